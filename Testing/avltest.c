@@ -0,0 +1,153 @@
+/*
+ *  File:   avltest.c
+ *  Author: Brett Heithold
+ *  Description: This program checks splitAVL and joinAVL against a plain
+ *  count of every value. Random trees with duplicates are split, split
+ *  again, joined back, thinned out by deletion and joined, and emptied.
+ *  After every step each tree must hold exactly the values it should, in
+ *  order, and its depth from statisticsAVL must stay within the AVL bound
+ *  of 1.44 log2(n + 2) for n nodes. It prints nothing and exits with 0 if
+ *  every check passes:
+ *
+ *      ./avltest [trees]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "avl.h"
+#include "integer.h"
+
+#define RANGE 1000  /* values are drawn from 0 through RANGE - 1 */
+
+
+static void check(AVL *, int *, int, int, char *);
+static void add(AVL *, int *, int);
+static void take(AVL *, int *, int);
+static int maximumDepth(AVL *);
+static void fail(char *, char *);
+
+
+int main(int argc, char **argv) {
+    int trees = argc > 1 ? atoi(argv[1]) : 300;
+    srand(1);
+    for (int i = 0; i < trees; i++) {
+        AVL *t = newAVL(displayINTEGER, compareINTEGER, freeINTEGER);
+        int counts[RANGE] = { 0 };
+        int n = i == 0 ? 0 : rand() % 3000;
+        int range = 1 + rand() % RANGE;
+        for (int j = 0; j < n; j++) add(t, counts, rand() % range);
+        check(t, counts, 0, RANGE, "insert");
+
+        // Split at a random pivot, then split the upper part again
+        int low = rand() % (RANGE + 1);
+        int high = low + rand() % (RANGE - low + 1);
+        INTEGER *pivot = newINTEGER(low);
+        AVL *upper = splitAVL(t, pivot);
+        freeINTEGER(pivot);
+        check(t, counts, 0, low, "split lower");
+        check(upper, counts, low, RANGE, "split upper");
+        pivot = newINTEGER(high);
+        AVL *top = splitAVL(upper, pivot);
+        freeINTEGER(pivot);
+        check(upper, counts, low, high, "nested split middle");
+        check(top, counts, high, RANGE, "nested split top");
+
+        // Join the three back together in order
+        joinAVL(upper, top);
+        check(upper, counts, low, RANGE, "join middle and top");
+        check(top, counts, 0, 0, "joined donor");
+        joinAVL(t, upper);
+        check(t, counts, 0, RANGE, "join all");
+        check(upper, counts, 0, 0, "joined donor");
+        freeAVL(upper);
+
+        // Thin out both sides of a split, then join them
+        pivot = newINTEGER(low);
+        upper = splitAVL(t, pivot);
+        freeINTEGER(pivot);
+        for (int j = 0; j < n / 2; j++) {
+            int v = rand() % range;
+            take(v < low ? t : upper, counts, v);
+        }
+        check(t, counts, 0, low, "delete lower");
+        check(upper, counts, low, RANGE, "delete upper");
+        joinAVL(t, upper);
+        check(t, counts, 0, RANGE, "join after delete");
+
+        // Empty the tree
+        for (int v = 0; v < RANGE; v++) {
+            while (counts[v] > 0) take(t, counts, v);
+        }
+        check(t, counts, 0, RANGE, "delete all");
+        freeAVL(t);
+        freeAVL(upper);
+        freeAVL(top);
+    }
+    return 0;
+}
+
+static void check(AVL *t, int *counts, int from, int to, char *step) {
+    // The tree must hold counts[v] copies of each v from from up to to,
+    // and nothing else
+    int total = 0;
+    int nodes = 0;
+    for (int v = from; v < to; v++) {
+        total += counts[v];
+        if (counts[v] > 0) nodes++;
+    }
+    if (sizeAVL(t) != nodes) fail(step, "size is wrong");
+    if (duplicatesAVL(t) != total - nodes) fail(step, "duplicate count is wrong");
+    AVLCURSOR *c = newAVLCURSOR(t);
+    int v = from;
+    for (firstAVLCURSOR(c); moreAVLCURSOR(c); nextAVLCURSOR(c)) {
+        while (v < to && counts[v] == 0) v++;
+        if (v == to) fail(step, "tree has an extra value");
+        if (getINTEGER(currentAVLCURSOR(c)) != v) fail(step, "values are out of order");
+        if (currentAVLCURSORcount(c) != counts[v]) fail(step, "a value's count is wrong");
+        v++;
+    }
+    freeAVLCURSOR(c);
+    while (v < to && counts[v] == 0) v++;
+    if (v != to) fail(step, "tree is missing a value");
+    if (maximumDepth(t) > 1.44 * log2(nodes + 2)) fail(step, "tree is out of balance");
+}
+
+static void add(AVL *t, int *counts, int v) {
+    // A duplicate only bumps a count, so the new INTEGER is not kept
+    INTEGER *value = newINTEGER(v);
+    insertAVL(t, value);
+    if (counts[v]++ > 0) freeINTEGER(value);
+}
+
+static void take(AVL *t, int *counts, int v) {
+    // deleteAVL hands back the probe for a duplicate, the stored value
+    // for the last copy, and NULL when v is not there
+    INTEGER *probe = newINTEGER(v);
+    void *removed = deleteAVL(t, probe);
+    if ((removed == NULL) != (counts[v] == 0)) fail("delete", "deleteAVL disagrees on a value");
+    if (removed != NULL) counts[v]--;
+    if (removed != NULL && removed != probe) freeINTEGER(removed);
+    freeINTEGER(probe);
+}
+
+static int maximumDepth(AVL *t) {
+    // Reads the depth back from the statistics report
+    FILE *fp = tmpfile();
+    if (fp == NULL) fail("statistics", "cannot make a temporary file");
+    statisticsAVL(t, fp);
+    rewind(fp);
+    char line[64];
+    int depth = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "Maximum depth: ", 15) == 0) depth = atoi(line + 15);
+    }
+    fclose(fp);
+    return depth;
+}
+
+static void fail(char *step, char *message) {
+    fprintf(stderr, "avltest: after %s: %s\n", step, message);
+    exit(1);
+}
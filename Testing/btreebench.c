@@ -0,0 +1,106 @@
+/*
+ *  File:   btreebench.c
+ *  Author: Brett Heithold
+ *  Description: This program times the btree module against avl.c with n
+ *  INTEGER keys, inserted in sequential and in random order. Every key is
+ *  then looked up once, in a strided order, so that successive lookups do
+ *  not share a path. With no n it runs 1M, 10M and 100M keys; at 100M the
+ *  AVL side alone needs about 14 GB. Each line gives the seconds taken by
+ *  each tree:
+ *
+ *      ./btreebench [n ...]
+ *      1000000 sequential: insert 0.150s vs AVL 0.670s, find 0.160s vs 0.357s
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "btree.h"
+#include "avl.h"
+#include "integer.h"
+
+#define STRIDE 1000003  /* a prime, so it steps through every key once */
+
+
+static void bench(int);
+static void run(int, int *, char *);
+static double now(void);
+
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        bench(1000000);
+        bench(10000000);
+        bench(100000000);
+    }
+    for (int i = 1; i < argc; i++) bench(atoi(argv[i]));
+    return 0;
+}
+
+static void bench(int n) {
+    int *keys = malloc(sizeof(int) * (n > 0 ? n : 1));
+    if (keys == NULL) {
+        fprintf(stderr, "btreebench: no room for %d keys\n", n);
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) keys[i] = i;
+    run(n, keys, "sequential");
+    // A fixed xorshift seed keeps the order the same from run to run
+    uint64_t x = 88172645463325252ULL;
+    for (int i = n - 1; i > 0; i--) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int j = x % (uint64_t)(i + 1);
+        int t = keys[i];
+        keys[i] = keys[j];
+        keys[j] = t;
+    }
+    run(n, keys, "random");
+    free(keys);
+}
+
+static void run(int n, int *keys, char *order) {
+    // Both trees get the same keys in the same order and free their own
+    INTEGER *probe = newINTEGER(0);
+    long found = 0;
+
+    double start = now();
+    BTREE *b = newBTREE(displayINTEGER, compareINTEGER, freeINTEGER);
+    for (int i = 0; i < n; i++) insertBTREE(b, newINTEGER(keys[i]));
+    double bInsert = now() - start;
+    start = now();
+    for (long i = 0, k = 0; i < n; i++, k = (k + STRIDE) % n) {
+        setINTEGER(probe, (int) k);
+        found += findBTREE(b, probe) != NULL;
+    }
+    double bFind = now() - start;
+    freeBTREE(b);
+
+    start = now();
+    AVL *t = newAVL(displayINTEGER, compareINTEGER, freeINTEGER);
+    for (int i = 0; i < n; i++) insertAVL(t, newINTEGER(keys[i]));
+    double tInsert = now() - start;
+    start = now();
+    for (long i = 0, k = 0; i < n; i++, k = (k + STRIDE) % n) {
+        setINTEGER(probe, (int) k);
+        found += findAVL(t, probe) != NULL;
+    }
+    double tFind = now() - start;
+    freeAVL(t);
+
+    freeINTEGER(probe);
+    if (found != 2L * n) fprintf(stderr, "btreebench: %ld of %d keys found\n", found, 2 * n);
+    printf("%d %s: insert %.3fs vs AVL %.3fs, find %.3fs vs %.3fs\n",
+            n, order, bInsert, tInsert, bFind, tFind);
+    fflush(stdout);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,183 @@
+/*
+ *  File:   btreetest.c
+ *  Author: Brett Heithold
+ *  Description: This program checks the btree module against a plain count
+ *  of every value. Random trees with duplicates are built by insertion and
+ *  by loadBTREE, thinned out by deletion and emptied. After every step the
+ *  tree must hold exactly the values it should: walked forward and back
+ *  with a cursor, looked up one by one and sought from every value, and its
+ *  depth must be no more than a tree of half-full nodes would need. It
+ *  prints nothing and exits with 0 if every check passes:
+ *
+ *      ./btreetest [trees]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btree.h"
+#include "integer.h"
+
+#define RANGE 2000  /* values are drawn from 0 through RANGE - 1 */
+#define LEAF_MIN 9  /* fewest values in a leaf other than the root */
+#define INNER_MIN 8 /* fewest children of an internal node other than the root */
+
+
+static void check(BTREE *, int *, char *);
+static void add(BTREE *, int *, int);
+static void take(BTREE *, int *, int);
+static BTREE *load(int *, int, int);
+static int depths(BTREE *, int *);
+static void fail(char *, char *);
+
+
+int main(int argc, char **argv) {
+    int trees = argc > 1 ? atoi(argv[1]) : 200;
+    srand(1);
+    for (int i = 0; i < trees; i++) {
+        int counts[RANGE] = { 0 };
+        int n = i == 0 ? 0 : rand() % 5000;
+        int range = 1 + rand() % RANGE;
+        BTREE *t;
+        if (i % 2 == 0) {
+            t = newBTREE(displayINTEGER, compareINTEGER, freeINTEGER);
+            for (int j = 0; j < n; j++) add(t, counts, rand() % range);
+            check(t, counts, "insert");
+        }
+        else {
+            t = load(counts, n, range);
+            check(t, counts, "load");
+            for (int j = 0; j < n / 4; j++) add(t, counts, rand() % range);
+            check(t, counts, "insert after load");
+        }
+
+        // Deleting can merge and borrow between nodes and move separators
+        for (int j = 0; j < n / 2; j++) take(t, counts, rand() % range);
+        check(t, counts, "delete");
+        for (int v = 0; v < RANGE; v++) {
+            while (counts[v] > 0) take(t, counts, v);
+        }
+        check(t, counts, "delete all");
+        freeBTREE(t);
+    }
+    return 0;
+}
+
+static void check(BTREE *t, int *counts, char *step) {
+    int total = 0;
+    int nodes = 0;
+    for (int v = 0; v < RANGE; v++) {
+        total += counts[v];
+        if (counts[v] > 0) nodes++;
+    }
+    if (sizeBTREE(t) != nodes) fail(step, "size is wrong");
+    if (duplicatesBTREE(t) != total - nodes) fail(step, "duplicate count is wrong");
+    int minimum;
+    int maximum = depths(t, &minimum);
+    if (minimum != maximum) fail(step, "leaves are at different depths");
+    if ((nodes == 0) != (maximum == -1)) fail(step, "depth of an empty tree is wrong");
+    // A root with two children over half-full nodes holds at least this many
+    long fewest = maximum > 0 ? 2L * LEAF_MIN : 0;
+    for (int d = 1; d < maximum; d++) fewest *= INNER_MIN;
+    if (nodes < fewest) fail(step, "tree is deeper than its values need");
+
+    // Forward, then backward, with counts
+    BTREECURSOR *c = newBTREECURSOR(t);
+    int v = 0;
+    for (firstBTREECURSOR(c); moreBTREECURSOR(c); nextBTREECURSOR(c)) {
+        while (v < RANGE && counts[v] == 0) v++;
+        if (v == RANGE) fail(step, "cursor finds an extra value");
+        if (getINTEGER(currentBTREECURSOR(c)) != v) fail(step, "cursor is out of order");
+        if (currentBTREECURSORcount(c) != counts[v]) fail(step, "cursor count is wrong");
+        v++;
+    }
+    while (v < RANGE && counts[v] == 0) v++;
+    if (v != RANGE) fail(step, "cursor misses a value");
+    v = RANGE - 1;
+    for (lastBTREECURSOR(c); moreBTREECURSOR(c); prevBTREECURSOR(c)) {
+        while (v >= 0 && counts[v] == 0) v--;
+        if (v < 0 || getINTEGER(currentBTREECURSOR(c)) != v) fail(step, "reverse cursor is wrong");
+        v--;
+    }
+    while (v >= 0 && counts[v] == 0) v--;
+    if (v >= 0) fail(step, "reverse cursor misses a value");
+
+    // Every value is found with its count, and a seek lands on the
+    // smallest value not less than the one sought
+    for (v = 0; v < RANGE; v++) {
+        INTEGER *probe = newINTEGER(v);
+        void *found = findBTREE(t, probe);
+        if ((found != NULL) != (counts[v] > 0)) fail(step, "find is wrong");
+        if (found != NULL && getINTEGER(found) != v) fail(step, "find returns another value");
+        if (findBTREEcount(t, probe) != counts[v]) fail(step, "find count is wrong");
+        seekBTREECURSOR(c, probe);
+        int next = v;
+        while (next < RANGE && counts[next] == 0) next++;
+        if (next == RANGE && moreBTREECURSOR(c)) fail(step, "seek past the end finds a value");
+        if (next < RANGE && (!moreBTREECURSOR(c) || getINTEGER(currentBTREECURSOR(c)) != next)) {
+            fail(step, "seek lands on the wrong value");
+        }
+        freeINTEGER(probe);
+    }
+    freeBTREECURSOR(c);
+}
+
+static void add(BTREE *t, int *counts, int v) {
+    // A duplicate only bumps a count, so the new INTEGER is not kept
+    INTEGER *value = newINTEGER(v);
+    insertBTREE(t, value);
+    if (counts[v]++ > 0) freeINTEGER(value);
+}
+
+static void take(BTREE *t, int *counts, int v) {
+    // deleteBTREE hands back the probe for a duplicate, the stored value
+    // for the last copy, and NULL when v is not there
+    INTEGER *probe = newINTEGER(v);
+    void *removed = deleteBTREE(t, probe);
+    if ((removed == NULL) != (counts[v] == 0)) fail("delete", "deleteBTREE disagrees on a value");
+    if (removed != NULL) counts[v]--;
+    if (removed != NULL && removed != probe) freeINTEGER(removed);
+    freeINTEGER(probe);
+}
+
+static BTREE *load(int *counts, int n, int range) {
+    // Only the first of each run of equal values is kept by loadBTREE
+    for (int j = 0; j < n; j++) counts[rand() % range]++;
+    void **values = malloc(sizeof(void *) * (n > 0 ? n : 1));
+    int k = 0;
+    for (int v = 0; v < RANGE; v++) {
+        for (int j = 0; j < counts[v]; j++) values[k++] = newINTEGER(v);
+    }
+    BTREE *t = newBTREE(displayINTEGER, compareINTEGER, freeINTEGER);
+    loadBTREE(t, values, n);
+    k = 0;
+    for (int v = 0; v < RANGE; v++) {
+        for (int j = 0; j < counts[v]; j++, k++) {
+            if (j > 0) freeINTEGER(values[k]);
+        }
+    }
+    free(values);
+    return t;
+}
+
+static int depths(BTREE *t, int *minimum) {
+    // Reads the depths back from the statistics report
+    FILE *fp = tmpfile();
+    if (fp == NULL) fail("statistics", "cannot make a temporary file");
+    statisticsBTREE(t, fp);
+    rewind(fp);
+    char line[64];
+    int maximum = -2;
+    *minimum = -2;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "Minimum depth: ", 15) == 0) *minimum = atoi(line + 15);
+        if (strncmp(line, "Maximum depth: ", 15) == 0) maximum = atoi(line + 15);
+    }
+    fclose(fp);
+    return maximum;
+}
+
+static void fail(char *step, char *message) {
+    fprintf(stderr, "btreetest: after %s: %s\n", step, message);
+    exit(1);
+}
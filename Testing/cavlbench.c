@@ -0,0 +1,163 @@
+/*
+ *  File:   cavlbench.c
+ *  Author: Brett Heithold
+ *  Description: This program measures cavl read throughput while a writer
+ *  is busy. The tree holds keys 0 through KEYS - 1, half of them present
+ *  at the start. One writer toggles random keys in and out while 1, 2, 4,
+ *  8 and 16 readers look up random keys, each run lasting the given number
+ *  of seconds. A reader checks that whatever it finds is the key it asked
+ *  for, and once the threads stop, every key's count and the tree's size
+ *  are checked against the writer's record. It exits with 1 if any check
+ *  fails, so a short run doubles as a concurrency smoke test:
+ *
+ *      ./cavlbench [seconds [readers ...]]
+ *      readers 1: 1.58 M lookups/s, writer 0.21 M writes/s
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "cavl.h"
+#include "integer.h"
+
+#define KEYS 100000
+
+
+/*
+ *  Type:   READER
+ *  Description: This is one reader thread's random state and tallies.
+ */
+typedef struct reader {
+    pthread_t thread;
+    uint64_t state;
+    long lookups;
+    long wrong;
+} READER;
+
+
+static void run(double, int);
+static void *lookUp(void *);
+static void *toggle(void *);
+static int next(uint64_t *);
+static double now(void);
+
+static CAVL *tree;
+static INTEGER *values[KEYS];   /* one value per key, shared by every run */
+static char present[KEYS];      /* the writer's record of the tree */
+static long writes;
+static atomic_int stop;
+static int failed;
+
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1;
+    for (int k = 0; k < KEYS; k++) values[k] = newINTEGER(k);
+    if (argc > 2) {
+        for (int i = 2; i < argc; i++) run(seconds, atoi(argv[i]));
+    }
+    else {
+        for (int readers = 1; readers <= 16; readers *= 2) run(seconds, readers);
+    }
+    for (int k = 0; k < KEYS; k++) freeINTEGER(values[k]);
+    return failed;
+}
+
+static void run(double seconds, int readers) {
+    // The values outlive the tree, since readers may still be looking at
+    // one that the writer has just deleted
+    tree = newCAVL(displayINTEGER, compareINTEGER, NULL);
+    for (int k = 0; k < KEYS; k++) {
+        present[k] = k % 2 == 0;
+        if (present[k]) insertCAVL(tree, values[k]);
+    }
+    READER *r = calloc(readers, sizeof(READER));
+    if (r == NULL) {
+        fprintf(stderr, "cavlbench: no room for %d readers\n", readers);
+        exit(1);
+    }
+    writes = 0;
+    atomic_store(&stop, 0);
+    pthread_t writer;
+    for (int i = 0; i < readers; i++) {
+        r[i].state = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&r[i].thread, NULL, lookUp, &r[i]);
+    }
+    pthread_create(&writer, NULL, toggle, NULL);
+    double start = now();
+    struct timespec pause = { (time_t) seconds, (long)((seconds - (time_t) seconds) * 1e9) };
+    nanosleep(&pause, NULL);
+    atomic_store(&stop, 1);
+    long lookups = 0;
+    long wrong = 0;
+    for (int i = 0; i < readers; i++) {
+        pthread_join(r[i].thread, NULL);
+        lookups += r[i].lookups;
+        wrong += r[i].wrong;
+    }
+    pthread_join(writer, NULL);
+    double elapsed = now() - start;
+
+    int reader = registerCAVL(tree);
+    int expected = 0;
+    for (int k = 0; k < KEYS; k++) {
+        expected += present[k];
+        if (findCAVLcount(tree, reader, values[k]) != present[k]) wrong++;
+    }
+    if (sizeCAVL(tree) != expected || duplicatesCAVL(tree) != 0) wrong++;
+    printf("readers %d: %.2f M lookups/s, writer %.2f M writes/s\n",
+            readers, lookups / elapsed / 1e6, writes / elapsed / 1e6);
+    fflush(stdout);
+    if (wrong > 0) {
+        fprintf(stderr, "cavlbench: %ld wrong answers with %d readers\n", wrong, readers);
+        failed = 1;
+    }
+    freeCAVL(tree);
+    free(r);
+}
+
+static void *lookUp(void *arg) {
+    READER *r = arg;
+    int reader = registerCAVL(tree);
+    INTEGER *probe = newINTEGER(0);
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        int k = next(&r->state);
+        setINTEGER(probe, k);
+        INTEGER *found = findCAVL(tree, reader, probe);
+        if (found != NULL && found != values[k]) r->wrong++;
+        r->lookups++;
+    }
+    freeINTEGER(probe);
+    return NULL;
+}
+
+static void *toggle(void *arg) {
+    (void) arg;
+    uint64_t state = 88172645463325252ULL;
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        int k = next(&state);
+        if (present[k]) deleteCAVL(tree, values[k]);
+        else insertCAVL(tree, values[k]);
+        present[k] = !present[k];
+        writes++;
+    }
+    return NULL;
+}
+
+static int next(uint64_t *state) {
+    // An xorshift step, reduced to a key
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state % KEYS;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
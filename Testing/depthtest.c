@@ -0,0 +1,220 @@
+/*
+ *  File:   depthtest.c
+ *  Author: Brett Heithold
+ *  Description: This program checks the depths that BST and AVL keep
+ *  cached in their nodes against a recursive walk of the tree. Random
+ *  trees are grown and shrunk by insertion and deletion, and the AVL trees
+ *  are also split and joined. After every step the minimum and maximum
+ *  depth from the statistics report must match the walk: the maximum depth
+ *  is the height, and the minimum depth is the distance from the root to
+ *  the nearest node that is missing a child. A BST is walked through its
+ *  nodes; an AVL is walked by reading back the nested form printed by
+ *  displayAVLdebug. It prints nothing and exits with 0 if every check
+ *  passes:
+ *
+ *      ./depthtest [trees]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bst.h"
+#include "avl.h"
+#include "integer.h"
+
+#define RANGE 1000  /* values are drawn from 0 through RANGE - 1 */
+
+
+static void checkBST(BST *, char *);
+static void checkAVL(AVL *, char *);
+static void walkBST(BSTNODE *, int *, int *);
+static char *walkDisplay(char *, int *, int *);
+static void readDepths(FILE *, int *, int *);
+static void addBST(BST *, int);
+static void takeBST(BST *, int);
+static void takeAVL(AVL *, int *, int);
+static void fail(char *, char *);
+
+
+int main(int argc, char **argv) {
+    int trees = argc > 1 ? atoi(argv[1]) : 200;
+    srand(1);
+    for (int i = 0; i < trees; i++) {
+        int n = i == 0 ? 0 : rand() % 2000;
+        int range = 1 + rand() % RANGE;
+
+        // A BST tells a left child from a right one by value, so it is only
+        // given distinct values
+        BST *b = newBST(displayINTEGER, compareINTEGER, NULL, freeINTEGER);
+        checkBST(b, "new");
+        for (int j = 0; j < n; j++) {
+            addBST(b, rand() % range);
+            if (j % 97 == 0) checkBST(b, "insert");
+        }
+        checkBST(b, "insert");
+        for (int j = 0; j < n; j++) {
+            if (rand() % 3 == 0) addBST(b, rand() % range);
+            else takeBST(b, rand() % range);
+            if (j % 97 == 0) checkBST(b, "mixed");
+        }
+        checkBST(b, "mixed");
+        while (sizeBST(b) > 0) {
+            takeBST(b, getINTEGER(getBSTNODEvalue(getBSTroot(b))));
+            if (sizeBST(b) % 97 == 0) checkBST(b, "delete root");
+        }
+        checkBST(b, "delete all");
+        freeBST(b);
+
+        // An AVL keeps duplicates as counts, so only distinct values matter
+        AVL *t = newAVL(displayINTEGER, compareINTEGER, freeINTEGER);
+        int counts[RANGE] = { 0 };
+        checkAVL(t, "new");
+        for (int j = 0; j < n; j++) {
+            int v = rand() % range;
+            INTEGER *value = newINTEGER(v);
+            insertAVL(t, value);
+            if (counts[v]++ > 0) freeINTEGER(value);
+            if (j % 97 == 0) checkAVL(t, "insert");
+        }
+        checkAVL(t, "insert");
+        for (int j = 0; j < n / 2; j++) {
+            takeAVL(t, counts, rand() % range);
+            if (j % 97 == 0) checkAVL(t, "delete");
+        }
+        checkAVL(t, "delete");
+
+        // Split at a random pivot and join back
+        INTEGER *pivot = newINTEGER(rand() % (RANGE + 1));
+        AVL *upper = splitAVL(t, pivot);
+        freeINTEGER(pivot);
+        checkAVL(t, "split lower");
+        checkAVL(upper, "split upper");
+        joinAVL(t, upper);
+        checkAVL(t, "join");
+        freeAVL(upper);
+
+        for (int v = 0; v < RANGE; v++) {
+            while (counts[v] > 0) takeAVL(t, counts, v);
+        }
+        checkAVL(t, "delete all");
+        freeAVL(t);
+    }
+    return 0;
+}
+
+static void checkBST(BST *t, char *step) {
+    int minDepth = -1;
+    int maxDepth = -1;
+    if (getBSTroot(t) != NULL) walkBST(getBSTroot(t), &minDepth, &maxDepth);
+    FILE *fp = tmpfile();
+    if (fp == NULL) fail(step, "cannot make a temporary file");
+    statisticsBST(t, fp);
+    int cachedMin, cachedMax;
+    readDepths(fp, &cachedMin, &cachedMax);
+    if (cachedMin != minDepth) fail(step, "BST minimum depth is wrong");
+    if (cachedMax != maxDepth) fail(step, "BST maximum depth is wrong");
+}
+
+static void checkAVL(AVL *t, char *step) {
+    FILE *fp = tmpfile();
+    if (fp == NULL) fail(step, "cannot make a temporary file");
+    displayAVLdebug(t, fp);
+    long length = ftell(fp);
+    char *text = malloc(length + 1);
+    rewind(fp);
+    if (fread(text, 1, length, fp) != (size_t) length) fail(step, "cannot read the display back");
+    text[length] = '\0';
+    int minDepth = -1;
+    int maxDepth = -1;
+    if (strcmp(text, "[]") != 0) {
+        char *end = walkDisplay(text + 1, &minDepth, &maxDepth);
+        if (strcmp(end, "]") != 0) fail(step, "display does not parse");
+    }
+    free(text);
+    fclose(fp);
+
+    fp = tmpfile();
+    if (fp == NULL) fail(step, "cannot make a temporary file");
+    statisticsAVL(t, fp);
+    int cachedMin, cachedMax;
+    readDepths(fp, &cachedMin, &cachedMax);
+    if (cachedMin != minDepth) fail(step, "AVL minimum depth is wrong");
+    if (cachedMax != maxDepth) fail(step, "AVL maximum depth is wrong");
+}
+
+static void walkBST(BSTNODE *n, int *minDepth, int *maxDepth) {
+    // Finds the depths of the subtree at n the slow way, by recursion
+    BSTNODE *left = getBSTNODEleft(n);
+    BSTNODE *right = getBSTNODEright(n);
+    int leftMin = -1, leftMax = -1, rightMin = -1, rightMax = -1;
+    if (left != NULL) walkBST(left, &leftMin, &leftMax);
+    if (right != NULL) walkBST(right, &rightMin, &rightMax);
+    *maxDepth = (leftMax > rightMax ? leftMax : rightMax) + 1;
+    if (left == NULL || right == NULL) *minDepth = 0;
+    else *minDepth = (leftMin < rightMin ? leftMin : rightMin) + 1;
+}
+
+static char *walkDisplay(char *s, int *minDepth, int *maxDepth) {
+    // Finds the depths of one subtree in the displayAVLdebug form, where a
+    // node is its value followed by each child subtree in " [...]". The
+    // value may carry a count such as "[3]" with no space before it. Returns
+    // the text just past the subtree.
+    while (*s != '\0' && *s != ' ' && *s != ']') {
+        if (*s == '[') s = strchr(s, ']');
+        s++;
+    }
+    int children = 0;
+    int childMin = 0, childMax = -1;
+    while (strncmp(s, " [", 2) == 0) {
+        int min, max;
+        s = walkDisplay(s + 2, &min, &max);
+        if (*s != ']') fail("display", "display does not parse");
+        s++;
+        if (children == 0 || min < childMin) childMin = min;
+        if (max > childMax) childMax = max;
+        children++;
+    }
+    *maxDepth = childMax + 1;
+    *minDepth = children < 2 ? 0 : childMin + 1;
+    return s;
+}
+
+static void readDepths(FILE *fp, int *minDepth, int *maxDepth) {
+    // Reads the depths back from a statistics report, then closes fp
+    rewind(fp);
+    char line[64];
+    *minDepth = *maxDepth = -2;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "Minimum depth: ", 15) == 0) *minDepth = atoi(line + 15);
+        if (strncmp(line, "Maximum depth: ", 15) == 0) *maxDepth = atoi(line + 15);
+    }
+    fclose(fp);
+}
+
+static void addBST(BST *t, int v) {
+    INTEGER *value = newINTEGER(v);
+    if (findBST(t, value) == NULL) insertBST(t, value);
+    else freeINTEGER(value);
+}
+
+static void takeBST(BST *t, int v) {
+    INTEGER *probe = newINTEGER(v);
+    BSTNODE *n = deleteBST(t, probe);
+    if (n != NULL) freeBSTNODE(n, freeINTEGER);
+    freeINTEGER(probe);
+}
+
+static void takeAVL(AVL *t, int *counts, int v) {
+    // deleteAVL hands back the probe for a duplicate and the stored value
+    // for the last copy
+    INTEGER *probe = newINTEGER(v);
+    void *removed = deleteAVL(t, probe);
+    if (removed != NULL) counts[v]--;
+    if (removed != NULL && removed != probe) freeINTEGER(removed);
+    freeINTEGER(probe);
+}
+
+static void fail(char *step, char *message) {
+    fprintf(stderr, "depthtest: after %s: %s\n", step, message);
+    exit(1);
+}
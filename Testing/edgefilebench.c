@@ -0,0 +1,150 @@
+/*
+ *  File:   edgefilebench.c
+ *  Author: Brett Heithold
+ *  Description: This program times the edgefile tokenizer on each file
+ *  named on the command line, once a record at a time with readEDGEFILE
+ *  and then in batches with simdEDGEFILE held to the scalar, SSE4.2 and
+ *  AVX2 paths in turn. Each file is read the given number of times per
+ *  path and only parsed, not built into a graph. A path the processor
+ *  lacks is capped by simdEDGEFILE to the best one it has, and the line
+ *  says which path actually ran. With -g, each file is first written with
+ *  about size bytes of random records in the style of the Testing inputs;
+ *  the size may end in K, M or G:
+ *
+ *      ./edgefilebench [-r repeats] [-g size] file ...
+ *      Testing/2/p-2-9.data AVX2: 496.1 MB/s
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "edgefile.h"
+
+#define BATCH 4096      /* records asked for at a time */
+#define IDS 10000000    /* generated ids are drawn from 0 through IDS - 1 */
+#define WEIGHTS 1000    /* generated weights are drawn from 1 through WEIGHTS */
+
+
+static long parseSize(char *);
+static void generate(char *, long);
+static void bench(char *, int);
+static double run(EDGEFILE *, int, int, long *);
+static double now(void);
+
+
+int main(int argc, char **argv) {
+    int repeats = 5;
+    long size = 0;
+    int i = 1;
+    while (i + 1 < argc && argv[i][0] == '-') {
+        if (strcmp(argv[i], "-r") == 0) repeats = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-g") == 0) size = parseSize(argv[i + 1]);
+        else break;
+        i += 2;
+    }
+    if (i == argc || repeats < 1 || size < 0) {
+        fprintf(stderr, "usage: edgefilebench [-r repeats] [-g size] file ...\n");
+        return 1;
+    }
+    for (; i < argc; i++) {
+        if (size > 0) generate(argv[i], size);
+        bench(argv[i], repeats);
+    }
+    return 0;
+}
+
+static long parseSize(char *text) {
+    // Returns -1 for anything that is not a positive count of bytes
+    char *end;
+    long size = strtol(text, &end, 10);
+    if (*end == 'K') size <<= 10, end++;
+    else if (*end == 'M') size <<= 20, end++;
+    else if (*end == 'G') size <<= 30, end++;
+    return *end == '\0' && size > 0 ? size : -1;
+}
+
+static void generate(char *name, long size) {
+    // Writes "u v w ; " records, five to a line, until at least size
+    // bytes are out
+    FILE *fp = fopen(name, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "edgefilebench: cannot write %s\n", name);
+        exit(1);
+    }
+    static char buffer[1 << 20];
+    setvbuf(fp, buffer, _IOFBF, sizeof(buffer));
+    srand(1);
+    long written = 0;
+    for (long r = 1; written < size; r++) {
+        int u = rand() % IDS;
+        int v = rand() % IDS;
+        int w = 1 + rand() % WEIGHTS;
+        written += fprintf(fp, r % 5 == 0 ? "%d %d %d ; \n" : "%d %d %d ; ", u, v, w);
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "edgefilebench: cannot write %s\n", name);
+        exit(1);
+    }
+}
+
+static void bench(char *name, int repeats) {
+    char *names[] = { "scalar", "SSE4.2", "AVX2" };
+    EDGEFILE *f = newEDGEFILE(name);
+    if (f == NULL) {
+        fprintf(stderr, "edgefilebench: cannot open %s\n", name);
+        exit(1);
+    }
+    if (streamingEDGEFILE(f)) {
+        fprintf(stderr, "edgefilebench: %s is read as a stream and cannot be rewound\n", name);
+        exit(1);
+    }
+    skipEDGEFILE(f, EDGEFILE_SKIP_QUIETLY);
+    double megabytes = sizeEDGEFILE(f) * (double) repeats / 1e6;
+
+    // Level -1 stands for one record at a time
+    long expected;
+    double seconds = run(f, -1, repeats, &expected);
+    printf("%s one at a time: %.1f MB/s\n", name, megabytes / seconds);
+    for (int level = EDGEFILE_SCALAR; level <= EDGEFILE_AVX2; level++) {
+        int ran = simdEDGEFILE(f, level);
+        long records;
+        seconds = run(f, ran, repeats, &records);
+        if (records != expected) {
+            fprintf(stderr, "edgefilebench: %s: %s reads %ld records, not %ld\n",
+                    name, names[ran], records, expected);
+        }
+        printf("%s %s: %.1f MB/s\n", name, names[ran], megabytes / seconds);
+    }
+    fflush(stdout);
+    freeEDGEFILE(f);
+}
+
+static double run(EDGEFILE *f, int level, int repeats, long *records) {
+    EDGETRIPLE *batch = malloc(sizeof(EDGETRIPLE) * BATCH);
+    *records = 0;
+    double start = now();
+    for (int r = 0; r < repeats; r++) {
+        rewindEDGEFILE(f);
+        if (level < 0) {
+            int u, v, w;
+            while (readEDGEFILE(f, &u, &v, &w)) (*records)++;
+        }
+        else {
+            int n;
+            while ((n = readEDGEFILEbatch(f, batch, BATCH)) > 0) *records += n;
+        }
+    }
+    double seconds = now() - start;
+    free(batch);
+    *records /= repeats;
+    return seconds;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,167 @@
+/*
+ *  File:   edgefiletest.c
+ *  Author: Brett Heithold
+ *  Description: This program checks that every tokenizer code path reads
+ *  the same records. Each file named on the command line, and a set of
+ *  generated files, is read once a record at a time with readEDGEFILE and
+ *  then in batches with simdEDGEFILE held to the scalar, SSE4.2 and AVX2
+ *  paths in turn; the records and the count of skipped ones must match.
+ *  The generated files are padded so that numbers straddle the 1 KB
+ *  windows the vector paths classify, with signs, missing weights, long
+ *  runs of zeros and, in some, malformed records. A path the processor
+ *  lacks is capped by simdEDGEFILE to the best one it has. It prints
+ *  nothing and exits with 0 if every check passes:
+ *
+ *      ./edgefiletest [file ...]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "edgefile.h"
+
+#define WINDOW 1024     /* bytes the vector paths classify at once */
+#define BATCH 4096      /* records asked for at a time */
+
+
+static void compare(char *, char *);
+static EDGETRIPLE *readAll(char *, int, long *, long *);
+static void generate(FILE *, int);
+static void number(FILE *, int);
+static void space(FILE *, int);
+static void fail(char *, char *);
+
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) compare(argv[i], argv[i]);
+    srand(1);
+    for (int i = 0; i < 300; i++) {
+        char name[] = "/tmp/edgefiletestXXXXXX";
+        int fd = mkstemp(name);
+        FILE *fp = fd < 0 ? NULL : fdopen(fd, "w");
+        if (fp == NULL) fail(name, "cannot make a temporary file");
+        generate(fp, i);
+        fclose(fp);
+        char label[64];
+        sprintf(label, "generated input %d", i);
+        compare(name, label);
+        unlink(name);
+    }
+    return 0;
+}
+
+static void compare(char *name, char *label) {
+    // Level -1 stands for one record at a time, the reference
+    long count;
+    long skipped;
+    EDGETRIPLE *expected = readAll(name, -1, &count, &skipped);
+    for (int level = EDGEFILE_SCALAR; level <= EDGEFILE_AVX2; level++) {
+        long n;
+        long bad;
+        EDGETRIPLE *records = readAll(name, level, &n, &bad);
+        if (n != count) fail(label, "a path reads a different number of records");
+        if (bad != skipped) fail(label, "a path skips a different number of records");
+        for (long i = 0; i < n; i++) {
+            if (records[i].u != expected[i].u || records[i].v != expected[i].v ||
+                    records[i].weight != expected[i].weight) {
+                fail(label, "a path reads a different record");
+            }
+        }
+        free(records);
+    }
+    free(expected);
+}
+
+static EDGETRIPLE *readAll(char *name, int level, long *count, long *skipped) {
+    EDGEFILE *f = newEDGEFILE(name);
+    if (f == NULL) fail(name, "cannot open");
+    skipEDGEFILE(f, EDGEFILE_SKIP_QUIETLY);
+    long capacity = BATCH;
+    EDGETRIPLE *records = malloc(sizeof(EDGETRIPLE) * capacity);
+    *count = 0;
+    if (level < 0) {
+        int u, v, w;
+        while (readEDGEFILE(f, &u, &v, &w)) {
+            if (*count == capacity) records = realloc(records, sizeof(EDGETRIPLE) * (capacity *= 2));
+            records[*count].u = u;
+            records[*count].v = v;
+            records[(*count)++].weight = w;
+        }
+    }
+    else {
+        simdEDGEFILE(f, level);
+        int n;
+        do {
+            if (*count + BATCH > capacity) records = realloc(records, sizeof(EDGETRIPLE) * (capacity *= 2));
+            n = readEDGEFILEbatch(f, records + *count, BATCH);
+            *count += n;
+        } while (n > 0);
+    }
+    *skipped = skippedEDGEFILE(f);
+    freeEDGEFILE(f);
+    return records;
+}
+
+static void generate(FILE *fp, int seed) {
+    // A third of the inputs get malformed records; the rest are clean
+    int records = 1 + rand() % 2000;
+    int corrupt = seed % 3 == 2;
+    for (int r = 0; r < records; r++) {
+        if (rand() % 8 == 0) {
+            // Pad up to just short of a window edge, so the next number
+            // straddles it
+            long at = ftell(fp);
+            long edge = (at / WINDOW + 1) * WINDOW;
+            int spare = rand() % 12;
+            while (at < edge - spare) {
+                fputc(rand() % 4 == 0 ? '\n' : ' ', fp);
+                at++;
+            }
+        }
+        if (corrupt && rand() % 40 == 0) {
+            char *bad[] = { "1x 2 ;", "- 3 4 ;", "1 2 3 4 ;", ";", "+-5 6 ;", "7 ;", "8 9 @ ;" };
+            fputs(bad[rand() % 7], fp);
+            space(fp, 1);
+            continue;
+        }
+        number(fp, 0);
+        space(fp, 1);
+        number(fp, 0);
+        if (rand() % 5 != 0) {
+            space(fp, 1);
+            number(fp, 1);
+        }
+        space(fp, 0);
+        // The last record may end at the end of the file instead
+        if (r + 1 < records || rand() % 2) fputc(';', fp);
+        space(fp, 0);
+    }
+}
+
+static void number(FILE *fp, int weight) {
+    // Mostly short ids, sometimes any int, with or without a sign, and
+    // now and then a run of leading zeros longer than the vector paths take
+    int sign = rand() % 6;
+    if (sign == 0) fputc('-', fp);
+    else if (sign == 1 && weight) fputc('+', fp);
+    int zeros = rand() % 30 == 0 ? rand() % 20 : 0;
+    while (zeros-- > 0) fputc('0', fp);
+    int kind = rand() % 3;
+    int value = kind == 0 ? rand() % 10 : kind == 1 ? rand() % 100000 : rand();
+    fprintf(fp, "%d", value);
+}
+
+static void space(FILE *fp, int some) {
+    char *blanks = " \t\n\r\v\f";
+    int n = some + rand() % 3;
+    if (rand() % 20 == 0) n += rand() % 60;
+    while (n-- > 0) fputc(blanks[rand() % 10 < 7 ? 0 : rand() % 6], fp);
+}
+
+static void fail(char *label, char *message) {
+    fprintf(stderr, "edgefiletest: %s: %s\n", label, message);
+    exit(1);
+}
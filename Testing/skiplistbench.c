@@ -0,0 +1,226 @@
+/*
+ *  File:   skiplistbench.c
+ *  Author: Brett Heithold
+ *  Description: This program stress tests the skiplist module and times it
+ *  against avl.c behind one mutex. Keys 0 through KEYS - 1 start with the
+ *  even ones present; then 1, 2, 4, 8 and 16 threads share the given
+ *  number of operations, a quarter inserts, a quarter deletes and half
+ *  finds of random keys. Each thread keeps a tally of what it inserted
+ *  and deleted, and once the threads stop every key's count, the size,
+ *  the duplicates and the cursor order are checked against the tallies.
+ *  It exits with 1 if any check fails:
+ *
+ *      ./skiplistbench [operations [threads ...]]
+ *      threads 1: skiplist 1.22 M ops/s, AVL+mutex 0.59 M ops/s
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "skiplist.h"
+#include "avl.h"
+#include "integer.h"
+
+#define KEYS 100000
+
+
+/*
+ *  Type:   WORKER
+ *  Description: This is one thread's share of a run: its operations, its
+ *  random state, and how far it moved each key's count.
+ */
+typedef struct worker {
+    pthread_t thread;
+    long operations;
+    uint64_t state;
+    int *moved;
+} WORKER;
+
+
+static double run(int, WORKER *, void *(*)(void *));
+static void *stressSkipList(void *);
+static void *stressAVL(void *);
+static void checkSkipList(int, WORKER *);
+static void checkAVL(int, WORKER *);
+static int expected(int, WORKER *, int);
+static int next(uint64_t *);
+static void fail(char *, int);
+static double now(void);
+
+static SKIPLIST *list;
+static AVL *tree;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static INTEGER *values[KEYS];   /* one value per key, shared by every run */
+
+
+int main(int argc, char **argv) {
+    long operations = argc > 1 ? atol(argv[1]) : 2000000;
+    int counts[5] = { 1, 2, 4, 8, 16 };
+    int runs = argc > 2 ? argc - 2 : 5;
+    for (int k = 0; k < KEYS; k++) values[k] = newINTEGER(k);
+    for (int i = 0; i < runs; i++) {
+        int threads = argc > 2 ? atoi(argv[i + 2]) : counts[i];
+        WORKER *w = calloc(threads, sizeof(WORKER));
+        if (w == NULL) fail("no room for the threads", threads);
+        for (int t = 0; t < threads; t++) {
+            w[t].operations = operations / threads + (t < operations % threads);
+            w[t].moved = malloc(sizeof(int) * KEYS);
+            if (w[t].moved == NULL) fail("no room for the tallies", threads);
+        }
+
+        // The values outlive both structures, since a thread may still be
+        // looking at one that another has just deleted
+        list = newSKIPLIST(displayINTEGER, compareINTEGER, NULL);
+        int slot = registerSKIPLIST(list);
+        for (int k = 0; k < KEYS; k += 2) insertSKIPLIST(list, slot, values[k]);
+        double skipList = run(threads, w, stressSkipList);
+        checkSkipList(threads, w);
+        freeSKIPLIST(list);
+
+        tree = newAVL(displayINTEGER, compareINTEGER, NULL);
+        for (int k = 0; k < KEYS; k += 2) insertAVL(tree, values[k]);
+        double avl = run(threads, w, stressAVL);
+        checkAVL(threads, w);
+        freeAVL(tree);
+
+        printf("threads %d: skiplist %.2f M ops/s, AVL+mutex %.2f M ops/s\n",
+                threads, operations / skipList / 1e6, operations / avl / 1e6);
+        fflush(stdout);
+        for (int t = 0; t < threads; t++) free(w[t].moved);
+        free(w);
+    }
+    for (int k = 0; k < KEYS; k++) freeINTEGER(values[k]);
+    return 0;
+}
+
+static double run(int threads, WORKER *w, void *(*stress)(void *)) {
+    // Every run of a thread count uses the same seeds
+    for (int t = 0; t < threads; t++) {
+        w[t].state = 0x9E3779B97F4A7C15ULL * (t + 1);
+        for (int k = 0; k < KEYS; k++) w[t].moved[k] = 0;
+    }
+    double start = now();
+    for (int t = 0; t < threads; t++) pthread_create(&w[t].thread, NULL, stress, &w[t]);
+    for (int t = 0; t < threads; t++) pthread_join(w[t].thread, NULL);
+    return now() - start;
+}
+
+static void *stressSkipList(void *arg) {
+    WORKER *w = arg;
+    int slot = registerSKIPLIST(list);
+    INTEGER *probe = newINTEGER(0);
+    for (long i = 0; i < w->operations; i++) {
+        int k = next(&w->state);
+        int kind = w->state >> 32 & 3;
+        if (kind == 0) {
+            insertSKIPLIST(list, slot, values[k]);
+            w->moved[k]++;
+        }
+        else if (kind == 1) {
+            if (deleteSKIPLIST(list, slot, values[k]) != NULL) w->moved[k]--;
+        }
+        else {
+            setINTEGER(probe, k);
+            INTEGER *found = findSKIPLIST(list, slot, probe);
+            if (found != NULL && found != values[k]) fail("skiplist found another key", k);
+        }
+    }
+    freeINTEGER(probe);
+    return NULL;
+}
+
+static void *stressAVL(void *arg) {
+    WORKER *w = arg;
+    INTEGER *probe = newINTEGER(0);
+    for (long i = 0; i < w->operations; i++) {
+        int k = next(&w->state);
+        int kind = w->state >> 32 & 3;
+        pthread_mutex_lock(&lock);
+        if (kind == 0) {
+            insertAVL(tree, values[k]);
+            w->moved[k]++;
+        }
+        else if (kind == 1) {
+            if (deleteAVL(tree, values[k]) != NULL) w->moved[k]--;
+        }
+        else {
+            setINTEGER(probe, k);
+            INTEGER *found = findAVL(tree, probe);
+            if (found != NULL && found != values[k]) fail("AVL found another key", k);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+    freeINTEGER(probe);
+    return NULL;
+}
+
+static void checkSkipList(int threads, WORKER *w) {
+    int slot = registerSKIPLIST(list);
+    int nodes = 0;
+    int total = 0;
+    for (int k = 0; k < KEYS; k++) {
+        int count = expected(threads, w, k);
+        if (findSKIPLISTcount(list, slot, values[k]) != count) fail("skiplist count is wrong", k);
+        nodes += count > 0;
+        total += count;
+    }
+    if (sizeSKIPLIST(list) != nodes) fail("skiplist size is wrong", nodes);
+    if (duplicatesSKIPLIST(list) != total - nodes) fail("skiplist duplicates are wrong", nodes);
+    SKIPLISTCURSOR *c = newSKIPLISTCURSOR(list, slot);
+    int last = -1;
+    int seen = 0;
+    for (firstSKIPLISTCURSOR(c); moreSKIPLISTCURSOR(c); nextSKIPLISTCURSOR(c)) {
+        int k = getINTEGER(currentSKIPLISTCURSOR(c));
+        if (k <= last) fail("skiplist cursor is out of order", k);
+        if (currentSKIPLISTCURSORcount(c) != expected(threads, w, k)) {
+            fail("skiplist cursor count is wrong", k);
+        }
+        last = k;
+        seen++;
+    }
+    if (seen != nodes) fail("skiplist cursor misses a key", seen);
+    freeSKIPLISTCURSOR(c);
+}
+
+static void checkAVL(int threads, WORKER *w) {
+    int nodes = 0;
+    int total = 0;
+    for (int k = 0; k < KEYS; k++) {
+        int count = expected(threads, w, k);
+        if (findAVLcount(tree, values[k]) != count) fail("AVL count is wrong", k);
+        nodes += count > 0;
+        total += count;
+    }
+    if (sizeAVL(tree) != nodes) fail("AVL size is wrong", nodes);
+    if (duplicatesAVL(tree) != total - nodes) fail("AVL duplicates are wrong", nodes);
+}
+
+static int expected(int threads, WORKER *w, int k) {
+    // The starting count plus every thread's inserts less its deletes
+    int count = k % 2 == 0;
+    for (int t = 0; t < threads; t++) count += w[t].moved[k];
+    return count;
+}
+
+static int next(uint64_t *state) {
+    // An xorshift step, reduced to a key; the high bits pick the operation
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state % KEYS;
+}
+
+static void fail(char *message, int n) {
+    fprintf(stderr, "skiplistbench: %s (%d)\n", message, n);
+    exit(1);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
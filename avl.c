@@ -14,6 +14,8 @@
 typedef struct aval {
     void *value;
     int count;
+    int size;           // values in this subtree, duplicates included
+    int nodes;          // nodes in this subtree
     int leftHeight;
     int rightHeight;
     int height;
@@ -31,6 +33,8 @@ AVAL *newAVAL(
     assert(rv != 0);
     rv->value = v;
     rv->count = 1;
+    rv->size = 1;
+    rv->nodes = 1;
     rv->leftHeight = 0;
     rv->rightHeight = 0;
     rv->height = 1;
@@ -64,6 +68,11 @@ void decrementAVALcount(AVAL *av) {
     av->count--;
 }
 
+int getAVALsize(AVAL *av) {
+    assert(av != 0);
+    return av->size;
+}
+
 int getAVALheight(AVAL *av) {
     assert(av != 0);
     return av->height;
@@ -121,6 +130,20 @@ int getBalance(BSTNODE *);
 BSTNODE *sibling(BSTNODE *);
 BSTNODE *favoriteChild(BSTNODE *);
 int linear(BSTNODE *c, BSTNODE *p, BSTNODE *gp);
+static int size(BSTNODE *);
+static void setSize(BSTNODE *);
+static void resizePath(AVL *, BSTNODE *);
+static int nodes(BSTNODE *);
+static BSTNODE *detach(AVL *, BSTNODE *);
+static BSTNODE *join(AVL *, BSTNODE *, BSTNODE *, BSTNODE *);
+static void split(AVL *, BSTNODE *, void *, BSTNODE **, BSTNODE **);
+static void retrace(AVL *, BSTNODE *);
+static void setRoot(AVL *, BSTNODE *);
+static BSTNODE *lowerBound(AVL *, void *);
+static BSTNODE *minimum(BSTNODE *);
+static BSTNODE *maximum(BSTNODE *);
+static BSTNODE *successor(AVL *, BSTNODE *);
+static BSTNODE *predecessor(AVL *, BSTNODE *);
 
 
 struct AVL {
@@ -160,12 +183,14 @@ void insertAVL(AVL *t, void *v) {
     if (n == NULL) {
         // Tree does not contain value
         n = insertBST(t->store, temp);
+        resizePath(t, n);
         setBalance(n);
         t->insertionFixUp(t, n);
     }
     else {
         // Tree already contains the value
         incrementAVALcount(getBSTNODEvalue(n));
+        resizePath(t, n);
         free((AVAL *) temp);
     }
     t->size++;
@@ -200,22 +225,17 @@ void *deleteAVL(AVL *t, void *v) {
         if (getAVALcount(getBSTNODEvalue(n)) > 1) {
             // Value has duplicates
             decrementAVALcount(getBSTNODEvalue(n));
+            resizePath(t, n);
+            t->size--;
             rv = v;
         }
         else {
             // Value found, no duplicates
-            BSTNODE *leaf = swapToLeafBST(t->store, n);
+            BSTNODE *leaf = detach(t, n);
             rv = getAVALvalue(getBSTNODEvalue(leaf));
-            BSTNODE *p = getBSTNODEparent(leaf);
-            setBalance(leaf);
-            t->deletionFixUp(t, leaf);
-            pruneLeafBST(t->store, leaf);
-            setBalance(p); // FIXME: Am I correct???
-            setBSTsize(t->store, sizeBST(t->store) - 1);
             free((AVAL *) getBSTNODEvalue(leaf));
             freeBSTNODE(leaf, NULL);
         }
-        t->size--;
     }
     freeAVAL(temp);
     return rv;
@@ -237,6 +257,76 @@ void statisticsAVL(AVL *t, FILE *fp) {
     statisticsBST(t->store, fp);
 }
 
+int rankAVL(AVL *t, void *v) {
+    // Counts the values (duplicates included) that are less than v
+    assert(t != 0);
+    int rank = 0;
+    BSTNODE *n = getBSTroot(t->store);
+    while (n != NULL) {
+        AVAL *av = getBSTNODEvalue(n);
+        if (t->compare(v, getAVALvalue(av)) <= 0) {
+            n = getBSTNODEleft(n);
+        }
+        else {
+            rank += size(getBSTNODEleft(n)) + getAVALcount(av);
+            n = getBSTNODEright(n);
+        }
+    }
+    return rank;
+}
+
+void *selectAVL(AVL *t, int k) {
+    // Returns the value at 0-based position k in sorted order, duplicates
+    // included, or NULL if k is out of range
+    assert(t != 0);
+    BSTNODE *n = getBSTroot(t->store);
+    while (n != NULL) {
+        AVAL *av = getBSTNODEvalue(n);
+        int leftSize = size(getBSTNODEleft(n));
+        if (k < leftSize) {
+            n = getBSTNODEleft(n);
+        }
+        else if (k < leftSize + getAVALcount(av)) {
+            return getAVALvalue(av);
+        }
+        else {
+            k -= leftSize + getAVALcount(av);
+            n = getBSTNODEright(n);
+        }
+    }
+    return NULL;
+}
+
+AVL *splitAVL(AVL *t, void *v) {
+    // Moves the values not less than v into a new tree, which is returned;
+    // t keeps the values less than v. This runs in logarithmic time.
+    assert(t != 0);
+    AVL *rv = newAVL(t->display, t->compare, t->free);
+    BSTNODE *lo;
+    BSTNODE *hi;
+    split(t, getBSTroot(t->store), v, &lo, &hi);
+    setRoot(t, lo);
+    setRoot(rv, hi);
+    return rv;
+}
+
+void joinAVL(AVL *recipient, AVL *donor) {
+    // Moves every value of the donor into the recipient, leaving the donor
+    // empty; every donor value must be greater than every recipient value.
+    // This runs in logarithmic time.
+    assert(recipient != 0 && donor != 0);
+    BSTNODE *r = getBSTroot(donor->store);
+    setRoot(donor, NULL);
+    if (r == NULL) return;
+    if (getBSTroot(recipient->store) == NULL) {
+        setRoot(recipient, r);
+        return;
+    }
+    // The largest recipient node becomes the pivot between the two trees
+    BSTNODE *k = detach(recipient, maximum(getBSTroot(recipient->store)));
+    setRoot(recipient, join(recipient, getBSTroot(recipient->store), k, r));
+}
+
 void displayAVL(AVL *t, FILE *fp) {
     assert(t != 0);
     displayBSTdecorated(t->store, fp);
@@ -253,6 +343,85 @@ void freeAVL(AVL *t) {
     free(t);
 }
 
+int rangeAVL(AVL *t, void *lo, void *hi, void (*visit)(void *, int)) {
+    // Visits each distinct value in [lo, hi] in order, with its count
+    assert(t != 0);
+    int visited = 0;
+    BSTNODE *n = lowerBound(t, lo);
+    while (n != NULL) {
+        AVAL *av = getBSTNODEvalue(n);
+        if (t->compare(getAVALvalue(av), hi) > 0) break;
+        visit(getAVALvalue(av), getAVALcount(av));
+        visited++;
+        n = successor(t, n);
+    }
+    return visited;
+}
+
+
+/****************************** AVL cursors ******************************/
+
+// A cursor walks parent links, so each step is amortized constant time.
+// Inserting or deleting invalidates every cursor on the tree.
+struct AVLCURSOR {
+    AVL *tree;
+    BSTNODE *node;
+};
+
+AVLCURSOR *newAVLCURSOR(AVL *t) {
+    assert(t != 0);
+    AVLCURSOR *c = malloc(sizeof(AVLCURSOR));
+    assert(c != 0);
+    c->tree = t;
+    firstAVLCURSOR(c);
+    return c;
+}
+
+void firstAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0);
+    c->node = minimum(getBSTroot(c->tree->store));
+}
+
+void lastAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0);
+    c->node = maximum(getBSTroot(c->tree->store));
+}
+
+void seekAVLCURSOR(AVLCURSOR *c, void *v) {
+    // Moves to the smallest value that is not less than v
+    assert(c != 0);
+    c->node = lowerBound(c->tree, v);
+}
+
+int moreAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0);
+    return c->node != NULL;
+}
+
+void nextAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    c->node = successor(c->tree, c->node);
+}
+
+void prevAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    c->node = predecessor(c->tree, c->node);
+}
+
+void *currentAVLCURSOR(AVLCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    return getAVALvalue(getBSTNODEvalue(c->node));
+}
+
+int currentAVLCURSORcount(AVLCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    return getAVALcount(getBSTNODEvalue(c->node));
+}
+
+void freeAVLCURSOR(AVLCURSOR *c) {
+    free(c);
+}
+
 
 /*************************** Private methods ***************************/
 
@@ -383,6 +552,10 @@ void rotateTo(AVL *t, BSTNODE *y, BSTNODE *x) {
         setBSTNODEleft(y, x);
         setBSTNODEparent(x, y);
     }
+    // x is now the child of y
+    setSize(x);
+    setSize(y);
+    updateBSTdepths(t->store, x);
 }
 
 int isRoot(AVL *t, BSTNODE *n) {
@@ -412,6 +585,171 @@ int height(BSTNODE *n) {
     return lh > rh ? lh + 1 : rh + 1;
 }
 
+int size(BSTNODE *n) {
+    if (n == NULL) return 0;
+    return getAVALsize(getBSTNODEvalue(n));
+}
+
+void setSize(BSTNODE *n) {
+    // A node being deleted has a zero count and is no longer counted
+    assert(n != 0);
+    AVAL *av = getBSTNODEvalue(n);
+    BSTNODE *l = getBSTNODEleft(n);
+    BSTNODE *r = getBSTNODEright(n);
+    av->size = av->count + size(l) + size(r);
+    av->nodes = (av->count > 0) + nodes(l) + nodes(r);
+}
+
+int nodes(BSTNODE *n) {
+    if (n == NULL) return 0;
+    return ((AVAL *) getBSTNODEvalue(n))->nodes;
+}
+
+BSTNODE *detach(AVL *t, BSTNODE *n) {
+    // Removes the node holding n's value from the tree and returns it as a
+    // lone node, count and value intact
+    BSTNODE *leaf = swapToLeafBST(t->store, n);
+    AVAL *av = getBSTNODEvalue(leaf);
+    BSTNODE *p = getBSTNODEparent(leaf);
+    int count = av->count;
+    // The leaf no longer counts towards any subtree size
+    av->count = 0;
+    resizePath(t, leaf);
+    setBalance(leaf);
+    t->deletionFixUp(t, leaf);
+    pruneLeafBST(t->store, leaf);
+    // The fix-up runs with the leaf still hanging from p, and setBalance
+    // takes a child's height from its children, so p's balance still
+    // counts the leaf as height 1. Rotations in the fix-up never move the
+    // leaf off p, so p is the only node left to correct.
+    setBalance(p);
+    setBSTsize(t->store, sizeBST(t->store) - 1);
+    t->size -= count;
+    av->count = count;
+    setSize(leaf);
+    setBalance(leaf);
+    return leaf;
+}
+
+BSTNODE *join(AVL *t, BSTNODE *l, BSTNODE *k, BSTNODE *r) {
+    // Joins the subtrees l and r, whose values lie below and above the lone
+    // node k, into a single balanced subtree and returns its root. Only the
+    // spine of the taller subtree down to the other's height is touched.
+    int hl = l == NULL ? 0 : getAVALheight(getBSTNODEvalue(l));
+    int hr = r == NULL ? 0 : getAVALheight(getBSTNODEvalue(r));
+    BSTNODE *root = k;
+    BSTNODE *p = NULL;
+    if (hl > hr + 1) {
+        // Hang k on the right spine of l
+        root = l;
+        p = l;
+        while (getBSTNODEright(p) != NULL &&
+                getAVALheight(getBSTNODEvalue(getBSTNODEright(p))) > hr + 1) {
+            p = getBSTNODEright(p);
+        }
+        l = getBSTNODEright(p);
+        setBSTNODEright(p, k);
+    }
+    else if (hr > hl + 1) {
+        // Hang k on the left spine of r
+        root = r;
+        p = r;
+        while (getBSTNODEleft(p) != NULL &&
+                getAVALheight(getBSTNODEvalue(getBSTNODEleft(p))) > hl + 1) {
+            p = getBSTNODEleft(p);
+        }
+        r = getBSTNODEleft(p);
+        setBSTNODEleft(p, k);
+    }
+    setBSTNODEleft(k, l);
+    setBSTNODEright(k, r);
+    if (l != NULL) setBSTNODEparent(l, k);
+    if (r != NULL) setBSTNODEparent(r, k);
+    setBSTNODEparent(k, p == NULL ? k : p);
+    setSize(k);
+    setBalance(k);
+    if (p == NULL) {
+        updateBSTdepths(t->store, k);
+        return k;
+    }
+    // Rebalance from the attachment point up, with root as the tree's root
+    setBSTroot(t->store, root);
+    setBSTNODEparent(root, root);
+    updateBSTdepths(t->store, k);
+    retrace(t, p);
+    return getBSTroot(t->store);
+}
+
+void split(AVL *t, BSTNODE *n, void *v, BSTNODE **lo, BSTNODE **hi) {
+    // Splits the subtree at n into the values less than v and the rest; the
+    // recursion follows a single root-to-leaf path
+    if (n == NULL) {
+        *lo = NULL;
+        *hi = NULL;
+        return;
+    }
+    BSTNODE *l = getBSTNODEleft(n);
+    BSTNODE *r = getBSTNODEright(n);
+    setBSTNODEleft(n, NULL);
+    setBSTNODEright(n, NULL);
+    if (t->compare(getAVALvalue(getBSTNODEvalue(n)), v) < 0) {
+        BSTNODE *rlo;
+        split(t, r, v, &rlo, hi);
+        *lo = join(t, l, n, rlo);
+    }
+    else {
+        BSTNODE *lhi;
+        split(t, l, v, lo, &lhi);
+        *hi = join(t, lhi, n, r);
+    }
+}
+
+void retrace(AVL *t, BSTNODE *n) {
+    // Refreshes sizes and balances from n to the root, rotating wherever a
+    // node has become unbalanced by two
+    while (1) {
+        setSize(n);
+        setBalance(n);
+        if (getBalance(n) == 2 || getBalance(n) == -2) {
+            BSTNODE *z = getBalance(n) == 2 ? getBSTNODEleft(n) : getBSTNODEright(n);
+            BSTNODE *y = favoriteChild(z);
+            if (y && !linear(y, z, n)) {
+                t->rotateTo(t, y, z);
+                t->rotateTo(t, y, n);
+                setBalance(n);
+                setBalance(z);
+                setBalance(y);
+                n = y;
+            }
+            else {
+                t->rotateTo(t, z, n);
+                setBalance(n);
+                setBalance(z);
+                n = z;
+            }
+        }
+        if (t->isRoot(t, n)) break;
+        n = getBSTNODEparent(n);
+    }
+}
+
+void setRoot(AVL *t, BSTNODE *n) {
+    // Installs n as the whole tree of t and recounts t from it
+    setBSTroot(t->store, n);
+    if (n != NULL) setBSTNODEparent(n, n);
+    setBSTsize(t->store, nodes(n));
+    t->size = size(n);
+}
+
+void resizePath(AVL *t, BSTNODE *n) {
+    // Recomputes the subtree sizes from n up to the root
+    setSize(n);
+    while (!t->isRoot(t, n)) {
+        n = getBSTNODEparent(n);
+        setSize(n);
+    }
+}
+
 int getBalance(BSTNODE *n) {
     assert(n != 0);
     return getAVALbalance(getBSTNODEvalue(n));
@@ -464,3 +802,47 @@ int linear(BSTNODE *c, BSTNODE *p, BSTNODE *gp) {
     int rightLinear = getBSTNODEright(gp) == p && getBSTNODEright(p) == c;
     return leftLinear || rightLinear;
 }
+
+BSTNODE *lowerBound(AVL *t, void *v) {
+    BSTNODE *n = getBSTroot(t->store);
+    BSTNODE *candidate = NULL;
+    while (n != NULL) {
+        if (t->compare(getAVALvalue(getBSTNODEvalue(n)), v) >= 0) {
+            candidate = n;
+            n = getBSTNODEleft(n);
+        }
+        else {
+            n = getBSTNODEright(n);
+        }
+    }
+    return candidate;
+}
+
+BSTNODE *minimum(BSTNODE *n) {
+    if (n == NULL) return NULL;
+    while (getBSTNODEleft(n) != NULL) n = getBSTNODEleft(n);
+    return n;
+}
+
+BSTNODE *maximum(BSTNODE *n) {
+    if (n == NULL) return NULL;
+    while (getBSTNODEright(n) != NULL) n = getBSTNODEright(n);
+    return n;
+}
+
+BSTNODE *successor(AVL *t, BSTNODE *n) {
+    if (getBSTNODEright(n) != NULL) return minimum(getBSTNODEright(n));
+    // Climb until n is a left child; the root's parent is itself
+    while (!t->isRoot(t, n) && getBSTNODEright(getBSTNODEparent(n)) == n) {
+        n = getBSTNODEparent(n);
+    }
+    return t->isRoot(t, n) ? NULL : getBSTNODEparent(n);
+}
+
+BSTNODE *predecessor(AVL *t, BSTNODE *n) {
+    if (getBSTNODEleft(n) != NULL) return maximum(getBSTNODEleft(n));
+    while (!t->isRoot(t, n) && getBSTNODEleft(getBSTNODEparent(n)) == n) {
+        n = getBSTNODEparent(n);
+    }
+    return t->isRoot(t, n) ? NULL : getBSTNODEparent(n);
+}
@@ -21,9 +21,27 @@ extern void *findAVL(AVL *, void *);
 extern void *deleteAVL(AVL *, void *);
 extern int sizeAVL(AVL *);
 extern int duplicatesAVL(AVL *);
+extern int rankAVL(AVL *, void *);
+extern void *selectAVL(AVL *, int);
+extern AVL *splitAVL(AVL *, void *);
+extern void joinAVL(AVL *, AVL *);
 extern void statisticsAVL(AVL *, FILE *);
 extern void displayAVL(AVL *, FILE *);
 extern void displayAVLdebug(AVL *, FILE *);
 extern void freeAVL(AVL *);
+extern int rangeAVL(AVL *, void *, void *, void (*)(void *, int));
+
+typedef struct AVLCURSOR AVLCURSOR;
+
+extern AVLCURSOR *newAVLCURSOR(AVL *);
+extern void firstAVLCURSOR(AVLCURSOR *);
+extern void lastAVLCURSOR(AVLCURSOR *);
+extern void seekAVLCURSOR(AVLCURSOR *, void *);
+extern int moreAVLCURSOR(AVLCURSOR *);
+extern void nextAVLCURSOR(AVLCURSOR *);
+extern void prevAVLCURSOR(AVLCURSOR *);
+extern void *currentAVLCURSOR(AVLCURSOR *);
+extern int currentAVLCURSORcount(AVLCURSOR *);
+extern void freeAVLCURSOR(AVLCURSOR *);
 
 #endif // !__AVL_INCLUDED__
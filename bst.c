@@ -14,6 +14,7 @@
 
 // BSTNODE private method prototypes
 static int isLeaf(BSTNODE *n);
+static void setDepths(BSTNODE *n);
 
 
 /*
@@ -25,6 +26,8 @@ struct BSTNODE {
     BSTNODE *left;
     BSTNODE *right;
     BSTNODE *parent;
+    int height;         // steps to the deepest leaf below
+    int minDepth;       // steps to the nearest node with a NULL child
     int (*isLeaf)(BSTNODE *);
 };
 
@@ -42,6 +45,8 @@ BSTNODE *newBSTNODE(void *v) {
     n->left = NULL;
     n->right = NULL;
     n->parent = NULL;
+    n->height = 0;
+    n->minDepth = 0;
     n->isLeaf = isLeaf;
     return n;
 }
@@ -165,6 +170,23 @@ int isLeaf(BSTNODE *n) {
 }
 
 
+/*
+ *  Method (private): setDepths
+ *  Usage:  setDepths(n);
+ *  Description: This private method recomputes the cached height and
+ *  minimum depth of a node from those of its children.
+ */
+void setDepths(BSTNODE *n) {
+    assert(n != 0);
+    int lh = n->left != NULL ? n->left->height + 1 : 0;
+    int rh = n->right != NULL ? n->right->height + 1 : 0;
+    n->height = lh > rh ? lh : rh;
+    if (n->left == NULL || n->right == NULL) n->minDepth = 0;
+    else if (n->left->minDepth < n->right->minDepth) n->minDepth = n->left->minDepth + 1;
+    else n->minDepth = n->right->minDepth + 1;
+}
+
+
 // BST private method prototypes
 static void swapper(BSTNODE *x, BSTNODE *y);
 static int isRoot(BST *t, BSTNODE *n);
@@ -313,6 +335,7 @@ BSTNODE *insertBST(BST *t, void *value) {
         // Set the new node to be the right child of p
         setBSTNODEright(p, n);
     }
+    if (p != NULL) updateBSTdepths(t, p);
     t->size++;
     return n;
 }
@@ -390,14 +413,39 @@ void pruneLeafBST(BST *t, BSTNODE *leaf) {
     assert(t != 0);
     if (t->size == 1) {
         setBSTroot(t, NULL);
+        return;
     }
-    else if (t->isLeftChild(t, leaf)) {
-        setBSTNODEleft(getBSTNODEparent(leaf), NULL);
-        setBSTNODEparent(leaf, NULL);
+    BSTNODE *p = getBSTNODEparent(leaf);
+    if (t->isLeftChild(t, leaf)) {
+        setBSTNODEleft(p, NULL);
     }
     else {
-        setBSTNODEright(getBSTNODEparent(leaf), NULL);
-        setBSTNODEparent(leaf, NULL);
+        setBSTNODEright(p, NULL);
+    }
+    setBSTNODEparent(leaf, NULL);
+    updateBSTdepths(t, p);
+}
+
+
+/*
+ *  Method: updateBSTdepths
+ *  Usage:  updateBSTdepths(t, n);
+ *  Description: This method refreshes the cached depths after the children
+ *  of n have changed, as after a rotation that left n below its old child.
+ *  The parent of n is always refreshed as well; past that, the walk stops
+ *  at the first ancestor whose depths come out unchanged. Anything that
+ *  relinks nodes outside insertBST and pruneLeafBST must call it.
+ */
+void updateBSTdepths(BST *t, BSTNODE *n) {
+    assert(t != 0 && n != 0);
+    setDepths(n);
+    int steps = 0;
+    while (n != t->root && n->parent != n && n->parent != NULL) {
+        n = n->parent;
+        int height = n->height;
+        int minDepth = n->minDepth;
+        setDepths(n);
+        if (++steps > 1 && height == n->height && minDepth == n->minDepth) break;
     }
 }
 
@@ -421,7 +469,8 @@ int sizeBST(BST *t) {
  *  is the minimum number of steps from the root to a node with a NULL child.
  *  The maximum depth of a tree is the maximum number of steps from the root
  *  to a node with a NULL child. The depths of an empty tree are -1.
- *  This method runs in linear time.
+ *  Both depths are cached in the nodes, so this method runs in constant
+ *  time.
  *  Example Output:
  *                  Nodes: 8
  *                  Minimum depth: 2
@@ -546,8 +595,8 @@ void displayBSTdecorated(BST *t, FILE *fp) {
  *  Usage:  freeBST(tree);
  *  Description: This method frees a BST object by performing a postorder
  *  traversal of the tree freeing the BSTNODE objects. After freeing all of the
- *  BSTNODEs, the tree object itself is freed. This method makes use of a
- *  recursive helper function.
+ *  BSTNODEs, the tree object itself is freed. The teardown does not recurse,
+ *  so it is safe on degenerate trees.
  */
 void freeBST(BST *t) {
     t->freeTree(t, t->root);
@@ -622,30 +671,27 @@ int isRightChild(BST *t, BSTNODE *n) {
 /*
  *  Method (private):   getMinDepth
  *  Usage:  int minDepth = t->getMinDepth(t, t->root);
- *  Description:
+ *  Description: This private method returns the fewest steps from n to a
+ *  node with a NULL child, as cached in n.
  */
 int getMinDepth(BST *t, BSTNODE *n) {
     assert(t != 0);
     if (n == NULL) return 0;
-    if (getBSTNODEleft(n) == NULL || getBSTNODEright(n) == NULL) return 0;
-    int leftDepth = t->getMinDepth(t, n->left) + 1;
-    int rightDepth = t->getMinDepth(t, n->right) + 1;
-    return (leftDepth < rightDepth) ? leftDepth : rightDepth;
+    return n->minDepth;
 }
 
 
 /*
  *  Method (private):   getMaxDepth
  *  Usage:  int maxDepth = t->getMaxDepth(t, t->root);
- *  Description:
+ *  Description: This private method returns the most steps from n to a
+ *  leaf, as cached in n, or -1 for an empty tree.
  */
 int getMaxDepth(BST *t, BSTNODE *n) {
     assert(t != 0);
     if (t->root == NULL) return -1;
     if (n == NULL) return -1;
-    int leftDepth = t->getMaxDepth(t, n->left);
-    int rightDepth = t->getMaxDepth(t, n->right);
-    return (leftDepth > rightDepth) ? leftDepth + 1 : rightDepth + 1;
+    return n->height;
 }
 
 
@@ -728,31 +774,65 @@ BSTNODE *getPredecessor(BST *t, BSTNODE *n) {
 
 
 /*
- *  Method (private):
- *  Usage:
- *  Description:
+ *  Method (private):   displayPreorder
+ *  Usage:  t->displayPreorder(t, t->root, stdout);
+ *  Description: This private method displays the subtree at n in preorder,
+ *  bracketing each non-empty child subtree. It walks the parent pointers
+ *  in constant space.
  */
 void displayPreorder(BST *t, BSTNODE *n, FILE *fp) {
     assert(t != 0);
     if (n == NULL) return;
-    t->display(getBSTNODEvalue(n), fp);
-    if (n->left != NULL) fprintf(fp, " [");
-    t->displayPreorder(t, n->left, fp);
-    if (n->left != NULL) fprintf(fp, "]");
-    if (n->right != NULL) fprintf(fp, " [");
-    t->displayPreorder(t, n->right, fp);
-    if (n->right != NULL) fprintf(fp, "]");
+    BSTNODE *start = n;
+    BSTNODE *from = NULL;
+    while (1) {
+        if (from == NULL) {
+            // Arrived from above
+            t->display(getBSTNODEvalue(n), fp);
+            if (n->left != NULL || n->right != NULL) {
+                fprintf(fp, " [");
+                n = n->left != NULL ? n->left : n->right;
+                continue;
+            }
+        }
+        else if (from == n->left && n->right != NULL) {
+            fprintf(fp, " [");
+            from = NULL;
+            n = n->right;
+            continue;
+        }
+        if (n == start) break;
+        from = n;
+        n = n->parent;
+        fprintf(fp, "]");
+    }
 }
 
 
 /*
- *  Method (private):
- *  Usage:
- *  Description:
+ *  Method (private):   freeTree
+ *  Usage:  t->freeTree(t, t->root);
+ *  Description: This private method frees the subtree at n in postorder.
+ *  Each freed leaf is cut from its parent, which may then become a leaf in
+ *  turn, so the teardown needs no stack.
  */
 void freeTree(BST *t, BSTNODE *n) {
-    if (n == NULL) return;
-    t->freeTree(t, n->left);
-    t->freeTree(t, n->right);
-    freeBSTNODE(n, t->free);
+    BSTNODE *start = n;
+    while (n != NULL) {
+        if (n->left != NULL) {
+            n = n->left;
+            continue;
+        }
+        if (n->right != NULL) {
+            n = n->right;
+            continue;
+        }
+        BSTNODE *p = (n == start) ? NULL : n->parent;
+        if (p != NULL) {
+            if (p->left == n) p->left = NULL;
+            else p->right = NULL;
+        }
+        freeBSTNODE(n, t->free);
+        n = p;
+    }
 }
@@ -38,6 +38,7 @@ extern BSTNODE *findBST(BST *t, void *value);
 extern BSTNODE *deleteBST(BST *t, void *value);
 extern BSTNODE *swapToLeafBST(BST *t, BSTNODE *node);
 extern void pruneLeafBST(BST *t, BSTNODE *leaf);
+extern void updateBSTdepths(BST *t, BSTNODE *n);
 extern int sizeBST(BST *t);
 extern void statisticsBST(BST *t, FILE *fp);
 extern void displayBST(BST *t, FILE *fp);
@@ -0,0 +1,940 @@
+/*
+ *  File:   btree.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the btree module. Every
+ *  node is 256 bytes and 64-byte aligned, so a node search touches four
+ *  cache lines instead of one line per level of a binary tree. Values live
+ *  only in the leaves, which are chained in order for the cursors; internal
+ *  nodes hold separator copies of the first value of each right subtree.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "btree.h"
+#include "queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define NODE_ALIGNMENT 64
+#define LEAF_KEYS 19                    /* fills a 256-byte leaf */
+#define LEAF_MIN (LEAF_KEYS / 2)
+#define INNER_KEYS 15                   /* fills a 256-byte internal node */
+#define INNER_MIN (INNER_KEYS / 2)
+
+
+/*
+ *  Type:   BTNODE
+ *  Description: This is the header shared by leaves and internal nodes.
+ */
+typedef struct btnode {
+    int size;
+    int leaf;
+} BTNODE;
+
+typedef struct btleaf {
+    BTNODE header;
+    struct btleaf *next;
+    struct btleaf *prev;
+    void *keys[LEAF_KEYS];
+    int counts[LEAF_KEYS];
+} BTLEAF;
+
+typedef struct btinner {
+    BTNODE header;
+    void *keys[INNER_KEYS];
+    BTNODE *children[INNER_KEYS + 1];
+} BTINNER;
+
+
+// BTREE private method prototypes
+static BTLEAF *newBTLEAF(void);
+static BTINNER *newBTINNER(void);
+static int lowerBound(BTREE *t, void **keys, int size, void *v);
+static int upperBound(BTREE *t, void **keys, int size, void *v);
+static BTLEAF *findLeaf(BTREE *t, void *v);
+static BTLEAF *firstLeaf(BTREE *t);
+static BTLEAF *lastLeaf(BTREE *t);
+static BTNODE *insertInto(BTREE *t, BTNODE *n, void *v, void **sep);
+static int deleteFrom(BTREE *t, BTNODE *n, void *v, void **rv);
+static void fixChild(BTINNER *p, int i);
+static void mergeChildren(BTINNER *p, int i);
+static void replaceSeparator(BTREE *t, void *v);
+static int height(BTREE *t);
+static void displayNode(BTREE *t, BTNODE *n, FILE *fp);
+static void freeNodes(BTNODE *n);
+
+
+/*
+ *  Type:   BTREE
+ *  Description: This is the struct definition for the BTREE class. The size
+ *  counts duplicates, the keys field does not.
+ */
+struct BTREE {
+    BTNODE *root;
+    int size;
+    int keys;
+    void (*display)(void *, FILE *);
+    int (*compare)(void *, void *);
+    void (*free)(void *);
+};
+
+
+/*
+ *  Constructor: newBTREE
+ *  Usage:  BTREE *t = newBTREE(displayINTEGER, compareINTEGER, freeINTEGER);
+ *  Description: This is the constructor used to instantiate a new BTREE
+ *  object. An empty tree is a single empty leaf.
+ */
+BTREE *newBTREE(
+        void (*d)(void *, FILE *),
+        int (*c)(void *, void *),
+        void (*f)(void *)) {
+    BTREE *t = malloc(sizeof(BTREE));
+    assert(t != 0);
+    t->root = (BTNODE *) newBTLEAF();
+    t->size = 0;
+    t->keys = 0;
+    t->display = d;
+    t->compare = c;
+    t->free = f;
+    return t;
+}
+
+
+/*
+ *  Method: insertBTREE
+ *  Usage:  insertBTREE(t, value);
+ *  Description: This method inserts a value into the tree. If an equal value
+ *  is already present, its count is incremented instead. This method runs in
+ *  logarithmic time.
+ */
+void insertBTREE(BTREE *t, void *v) {
+    assert(t != 0);
+    void *sep = NULL;
+    BTNODE *right = insertInto(t, t->root, v, &sep);
+    if (right != NULL) {
+        // The root split, so the tree grows by one level
+        BTINNER *root = newBTINNER();
+        root->header.size = 1;
+        root->keys[0] = sep;
+        root->children[0] = t->root;
+        root->children[1] = right;
+        t->root = (BTNODE *) root;
+    }
+    t->size++;
+}
+
+
+/*
+ *  Method: loadBTREE
+ *  Usage:  loadBTREE(t, values, n);
+ *  Description: This method builds an empty tree bottom-up from an array of
+ *  n values sorted in ascending order. Equal neighbours are counted as
+ *  duplicates. Leaves and internal nodes are filled evenly, so every node
+ *  is at least half full. This method runs in linear time.
+ */
+void loadBTREE(BTREE *t, void **values, int n) {
+    assert(t != 0);
+    assert(t->size == 0);
+    if (n == 0) return;
+    int distinct = 1;
+    for (int i = 1; i < n; i++) {
+        assert(t->compare(values[i - 1], values[i]) <= 0);
+        if (t->compare(values[i - 1], values[i]) != 0) distinct++;
+    }
+
+    // Build the leaf level
+    int count = (distinct + LEAF_KEYS - 1) / LEAF_KEYS;
+    BTNODE **level = malloc(sizeof(BTNODE *) * count);
+    void **firsts = malloc(sizeof(void *) * count);
+    assert(level != 0 && firsts != 0);
+    BTLEAF *prev = NULL;
+    int next = 0;
+    for (int i = 0; i < count; i++) {
+        BTLEAF *leaf = newBTLEAF();
+        int share = distinct / count + (i < distinct % count ? 1 : 0);
+        while (leaf->header.size < share) {
+            int k = leaf->header.size++;
+            leaf->keys[k] = values[next];
+            leaf->counts[k] = 1;
+            next++;
+            while (next < n && t->compare(values[next], leaf->keys[k]) == 0) {
+                leaf->counts[k]++;
+                next++;
+            }
+        }
+        leaf->prev = prev;
+        if (prev != NULL) prev->next = leaf;
+        prev = leaf;
+        level[i] = (BTNODE *) leaf;
+        firsts[i] = leaf->keys[0];
+    }
+
+    // Build internal levels until a single node remains
+    while (count > 1) {
+        int parents = (count + INNER_KEYS) / (INNER_KEYS + 1);
+        int child = 0;
+        for (int i = 0; i < parents; i++) {
+            BTINNER *inner = newBTINNER();
+            int share = count / parents + (i < count % parents ? 1 : 0);
+            void *first = firsts[child];
+            for (int j = 0; j < share; j++, child++) {
+                inner->children[j] = level[child];
+                if (j > 0) inner->keys[j - 1] = firsts[child];
+            }
+            inner->header.size = share - 1;
+            level[i] = (BTNODE *) inner;
+            firsts[i] = first;
+        }
+        count = parents;
+    }
+
+    freeNodes(t->root);
+    t->root = level[0];
+    t->size = n;
+    t->keys = distinct;
+    free(level);
+    free(firsts);
+}
+
+
+/*
+ *  Method: findBTREEcount
+ *  Usage:  int count = findBTREEcount(t, value);
+ *  Description: This method returns the number of times a value has been
+ *  inserted, or zero if it is not in the tree.
+ */
+int findBTREEcount(BTREE *t, void *v) {
+    assert(t != 0);
+    BTLEAF *leaf = findLeaf(t, v);
+    int i = lowerBound(t, leaf->keys, leaf->header.size, v);
+    if (i < leaf->header.size && t->compare(v, leaf->keys[i]) == 0) {
+        return leaf->counts[i];
+    }
+    return 0;
+}
+
+
+/*
+ *  Method: findBTREE
+ *  Usage:  void *found = findBTREE(t, value);
+ *  Description: This method returns the stored value equal to the given
+ *  value, or NULL if there is none. This method runs in logarithmic time.
+ */
+void *findBTREE(BTREE *t, void *v) {
+    assert(t != 0);
+    BTLEAF *leaf = findLeaf(t, v);
+    int i = lowerBound(t, leaf->keys, leaf->header.size, v);
+    if (i < leaf->header.size && t->compare(v, leaf->keys[i]) == 0) {
+        return leaf->keys[i];
+    }
+    return NULL;
+}
+
+
+/*
+ *  Method: deleteBTREE
+ *  Usage:  void *removed = deleteBTREE(t, value);
+ *  Description: This method removes one occurrence of a value. As with
+ *  deleteAVL, a duplicated value only has its count decremented and the
+ *  given value is returned; otherwise the stored value is removed and
+ *  returned. NULL is returned if the value is not in the tree.
+ */
+void *deleteBTREE(BTREE *t, void *v) {
+    assert(t != 0);
+    void *rv = NULL;
+    int keys = t->keys;
+    deleteFrom(t, t->root, v, &rv);
+    if (!t->root->leaf && t->root->size == 0) {
+        // The root lost its last separator, so the tree shrinks by one level
+        BTNODE *old = t->root;
+        t->root = ((BTINNER *) old)->children[0];
+        free(old);
+    }
+    // A separator may still point at the removed value
+    if (t->keys < keys) replaceSeparator(t, rv);
+    return rv;
+}
+
+
+/*
+ *  Method: sizeBTREE
+ *  Usage:  int s = sizeBTREE(t);
+ *  Description: This method returns the number of distinct values stored.
+ */
+int sizeBTREE(BTREE *t) {
+    assert(t != 0);
+    return t->keys;
+}
+
+
+/*
+ *  Method: duplicatesBTREE
+ *  Usage:  int d = duplicatesBTREE(t);
+ *  Description: This method returns the number of duplicate insertions.
+ */
+int duplicatesBTREE(BTREE *t) {
+    assert(t != 0);
+    return t->size - t->keys;
+}
+
+
+/*
+ *  Method: statisticsBTREE
+ *  Usage:  statisticsBTREE(t, stdout);
+ *  Description: This method displays the same statistics as statisticsAVL.
+ *  Every leaf of a B+tree is at the same depth, so the minimum and maximum
+ *  depths are equal. This method runs in logarithmic time.
+ *  Example Output:
+ *                  Duplicates: 0
+ *                  Nodes: 40
+ *                  Minimum depth: 1
+ *                  Maximum depth: 1
+ */
+void statisticsBTREE(BTREE *t, FILE *fp) {
+    assert(t != 0);
+    int depth = t->keys > 0 ? height(t) - 1 : -1;
+    fprintf(fp, "Duplicates: %d\n", duplicatesBTREE(t));
+    fprintf(fp, "Nodes: %d\n", t->keys);
+    fprintf(fp, "Minimum depth: %d\n", depth);
+    fprintf(fp, "Maximum depth: %d\n", depth);
+}
+
+
+/*
+ *  Method: displayBTREE
+ *  Usage:  displayBTREE(t, stdout);
+ *  Description: This method displays the tree one level per line, with the
+ *  keys of each node enclosed in brackets. Counts above one are shown after
+ *  a value, as in displayAVL. This method runs in linear time.
+ *  Example Output:
+ *                  0: [7]
+ *                  1: [2 4[2] 5] [7 9]
+ */
+void displayBTREE(BTREE *t, FILE *fp) {
+    assert(t != 0);
+    if (t->keys == 0) return;
+    QUEUE *q = newQUEUE(NULL, NULL);
+    enqueue(q, t->root);
+    int level = 0;
+    int nodesAtLevel = 0;
+    while (1) {
+        nodesAtLevel = sizeQUEUE(q);
+        if (nodesAtLevel == 0) break;
+        fprintf(fp, "%d: ", level);
+        while (nodesAtLevel > 0) {
+            BTNODE *n = dequeue(q);
+            displayNode(t, n, fp);
+            if (nodesAtLevel > 1) fprintf(fp, " ");
+            if (!n->leaf) {
+                BTINNER *inner = (BTINNER *) n;
+                for (int i = 0; i <= n->size; i++) enqueue(q, inner->children[i]);
+            }
+            nodesAtLevel--;
+        }
+        fprintf(fp, "\n");
+        level++;
+    }
+    freeQUEUE(q);
+}
+
+
+/*
+ *  Method: displayBTREEdebug
+ *  Usage:  displayBTREEdebug(t, stdout);
+ *  Description: This method displays every value in order, with counts above
+ *  one shown after a value. This method runs in linear time.
+ *  Example Output:
+ *                  [2 4[2] 5 7 9]
+ */
+void displayBTREEdebug(BTREE *t, FILE *fp) {
+    assert(t != 0);
+    fprintf(fp, "[");
+    BTLEAF *leaf = firstLeaf(t);
+    int first = 1;
+    while (leaf != NULL) {
+        for (int i = 0; i < leaf->header.size; i++) {
+            if (!first) fprintf(fp, " ");
+            t->display(leaf->keys[i], fp);
+            if (leaf->counts[i] > 1) fprintf(fp, "[%d]", leaf->counts[i]);
+            first = 0;
+        }
+        leaf = leaf->next;
+    }
+    fprintf(fp, "]");
+}
+
+
+/*
+ *  Method: freeBTREE
+ *  Usage:  freeBTREE(t);
+ *  Description: This method frees every stored value (once, regardless of
+ *  its count) with the freeing function, if there is one, then the nodes
+ *  and the tree itself.
+ */
+void freeBTREE(BTREE *t) {
+    assert(t != 0);
+    if (t->free != NULL) {
+        BTLEAF *leaf = firstLeaf(t);
+        while (leaf != NULL) {
+            for (int i = 0; i < leaf->header.size; i++) t->free(leaf->keys[i]);
+            leaf = leaf->next;
+        }
+    }
+    freeNodes(t->root);
+    free(t);
+}
+
+
+/*
+ *  Type:   BTREECURSOR
+ *  Description: A cursor is a position within a leaf. Moving it is amortized
+ *  constant time, since it only follows the leaf chain. Any insertion or
+ *  deletion invalidates the cursors of a tree.
+ */
+struct BTREECURSOR {
+    BTREE *tree;
+    BTLEAF *leaf;
+    int index;
+};
+
+
+/*
+ *  Constructor: newBTREECURSOR
+ *  Usage:  BTREECURSOR *c = newBTREECURSOR(t);
+ *  Description: This is the constructor for a cursor positioned at the
+ *  smallest value of a tree.
+ */
+BTREECURSOR *newBTREECURSOR(BTREE *t) {
+    assert(t != 0);
+    BTREECURSOR *c = malloc(sizeof(BTREECURSOR));
+    assert(c != 0);
+    c->tree = t;
+    firstBTREECURSOR(c);
+    return c;
+}
+
+
+/*
+ *  Method: firstBTREECURSOR
+ *  Usage:  firstBTREECURSOR(c);
+ *  Description: This method moves a cursor to the smallest value.
+ */
+void firstBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0);
+    c->leaf = firstLeaf(c->tree);
+    c->index = 0;
+    if (c->leaf->header.size == 0) c->leaf = NULL;
+}
+
+
+/*
+ *  Method: lastBTREECURSOR
+ *  Usage:  lastBTREECURSOR(c);
+ *  Description: This method moves a cursor to the largest value.
+ */
+void lastBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0);
+    c->leaf = lastLeaf(c->tree);
+    c->index = c->leaf->header.size - 1;
+    if (c->leaf->header.size == 0) c->leaf = NULL;
+}
+
+
+/*
+ *  Method: seekBTREECURSOR
+ *  Usage:  seekBTREECURSOR(c, value);
+ *  Description: This method moves a cursor to the smallest value that is not
+ *  less than the given value. This method runs in logarithmic time.
+ */
+void seekBTREECURSOR(BTREECURSOR *c, void *v) {
+    assert(c != 0);
+    c->leaf = findLeaf(c->tree, v);
+    c->index = lowerBound(c->tree, c->leaf->keys, c->leaf->header.size, v);
+    if (c->index == c->leaf->header.size) {
+        c->leaf = c->leaf->next;
+        c->index = 0;
+    }
+}
+
+
+/*
+ *  Method: moreBTREECURSOR
+ *  Usage:  while (moreBTREECURSOR(c)) { ... }
+ *  Description: This method returns true if the cursor is on a value.
+ */
+int moreBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0);
+    return c->leaf != NULL;
+}
+
+
+/*
+ *  Method: nextBTREECURSOR
+ *  Usage:  nextBTREECURSOR(c);
+ *  Description: This method moves a cursor to the next larger value.
+ */
+void nextBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0 && c->leaf != NULL);
+    if (++c->index == c->leaf->header.size) {
+        c->leaf = c->leaf->next;
+        c->index = 0;
+    }
+}
+
+
+/*
+ *  Method: prevBTREECURSOR
+ *  Usage:  prevBTREECURSOR(c);
+ *  Description: This method moves a cursor to the next smaller value.
+ */
+void prevBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0 && c->leaf != NULL);
+    if (c->index-- == 0) {
+        c->leaf = c->leaf->prev;
+        if (c->leaf != NULL) c->index = c->leaf->header.size - 1;
+    }
+}
+
+
+/*
+ *  Method: currentBTREECURSOR
+ *  Usage:  void *v = currentBTREECURSOR(c);
+ *  Description: This method returns the value under a cursor.
+ */
+void *currentBTREECURSOR(BTREECURSOR *c) {
+    assert(c != 0 && c->leaf != NULL);
+    return c->leaf->keys[c->index];
+}
+
+
+/*
+ *  Method: currentBTREECURSORcount
+ *  Usage:  int count = currentBTREECURSORcount(c);
+ *  Description: This method returns the count of the value under a cursor.
+ */
+int currentBTREECURSORcount(BTREECURSOR *c) {
+    assert(c != 0 && c->leaf != NULL);
+    return c->leaf->counts[c->index];
+}
+
+
+/*
+ *  Method: freeBTREECURSOR
+ *  Usage:  freeBTREECURSOR(c);
+ *  Description: This method frees a cursor. The tree is not affected.
+ */
+void freeBTREECURSOR(BTREECURSOR *c) {
+    free(c);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Constructor (private): newBTLEAF
+ *  Usage:  BTLEAF *leaf = newBTLEAF();
+ *  Description: This private constructor returns an empty, aligned leaf.
+ */
+BTLEAF *newBTLEAF(void) {
+    void *p = NULL;
+    int result = posix_memalign(&p, NODE_ALIGNMENT, sizeof(BTLEAF));
+    assert(result == 0);
+    (void) result;
+    BTLEAF *leaf = p;
+    leaf->header.size = 0;
+    leaf->header.leaf = 1;
+    leaf->next = NULL;
+    leaf->prev = NULL;
+    return leaf;
+}
+
+
+/*
+ *  Constructor (private): newBTINNER
+ *  Usage:  BTINNER *n = newBTINNER();
+ *  Description: This private constructor returns an empty, aligned internal
+ *  node.
+ */
+BTINNER *newBTINNER(void) {
+    void *p = NULL;
+    int result = posix_memalign(&p, NODE_ALIGNMENT, sizeof(BTINNER));
+    assert(result == 0);
+    (void) result;
+    BTINNER *n = p;
+    n->header.size = 0;
+    n->header.leaf = 0;
+    return n;
+}
+
+
+/*
+ *  Method (private):   lowerBound
+ *  Usage:  int i = lowerBound(t, keys, size, v);
+ *  Description: This private method returns the index of the first key that
+ *  is not less than v, by binary search.
+ */
+int lowerBound(BTREE *t, void **keys, int size, void *v) {
+    int lo = 0;
+    int hi = size;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (t->compare(keys[mid], v) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+
+/*
+ *  Method (private):   upperBound
+ *  Usage:  int i = upperBound(t, keys, size, v);
+ *  Description: This private method returns the index of the first key that
+ *  is greater than v, which is the child of an internal node to descend
+ *  into.
+ */
+int upperBound(BTREE *t, void **keys, int size, void *v) {
+    int lo = 0;
+    int hi = size;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (t->compare(keys[mid], v) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+
+/*
+ *  Method (private):   findLeaf
+ *  Usage:  BTLEAF *leaf = findLeaf(t, v);
+ *  Description: This private method returns the leaf where v belongs.
+ */
+BTLEAF *findLeaf(BTREE *t, void *v) {
+    BTNODE *n = t->root;
+    while (!n->leaf) {
+        BTINNER *inner = (BTINNER *) n;
+        n = inner->children[upperBound(t, inner->keys, n->size, v)];
+    }
+    return (BTLEAF *) n;
+}
+
+
+/*
+ *  Method (private):   firstLeaf
+ *  Usage:  BTLEAF *leaf = firstLeaf(t);
+ *  Description: This private method returns the leftmost leaf.
+ */
+BTLEAF *firstLeaf(BTREE *t) {
+    BTNODE *n = t->root;
+    while (!n->leaf) n = ((BTINNER *) n)->children[0];
+    return (BTLEAF *) n;
+}
+
+
+/*
+ *  Method (private):   lastLeaf
+ *  Usage:  BTLEAF *leaf = lastLeaf(t);
+ *  Description: This private method returns the rightmost leaf.
+ */
+BTLEAF *lastLeaf(BTREE *t) {
+    BTNODE *n = t->root;
+    while (!n->leaf) n = ((BTINNER *) n)->children[n->size];
+    return (BTLEAF *) n;
+}
+
+
+/*
+ *  Method (private):   insertInto
+ *  Usage:  BTNODE *right = insertInto(t, n, v, &sep);
+ *  Description: This private method inserts v into the subtree rooted at n.
+ *  If n had to split, the new right sibling is returned and the separator
+ *  to add to the parent is stored in sep; otherwise NULL is returned.
+ */
+BTNODE *insertInto(BTREE *t, BTNODE *n, void *v, void **sep) {
+    if (n->leaf) {
+        BTLEAF *leaf = (BTLEAF *) n;
+        int i = lowerBound(t, leaf->keys, n->size, v);
+        if (i < n->size && t->compare(v, leaf->keys[i]) == 0) {
+            // Tree already contains the value
+            leaf->counts[i]++;
+            return NULL;
+        }
+        t->keys++;
+        if (n->size < LEAF_KEYS) {
+            memmove(&leaf->keys[i + 1], &leaf->keys[i], sizeof(void *) * (n->size - i));
+            memmove(&leaf->counts[i + 1], &leaf->counts[i], sizeof(int) * (n->size - i));
+            leaf->keys[i] = v;
+            leaf->counts[i] = 1;
+            n->size++;
+            return NULL;
+        }
+        // Leaf is full, split it in half around the new value
+        void *keys[LEAF_KEYS + 1];
+        int counts[LEAF_KEYS + 1];
+        memcpy(keys, leaf->keys, sizeof(void *) * i);
+        memcpy(counts, leaf->counts, sizeof(int) * i);
+        keys[i] = v;
+        counts[i] = 1;
+        memcpy(&keys[i + 1], &leaf->keys[i], sizeof(void *) * (LEAF_KEYS - i));
+        memcpy(&counts[i + 1], &leaf->counts[i], sizeof(int) * (LEAF_KEYS - i));
+        BTLEAF *right = newBTLEAF();
+        int half = (LEAF_KEYS + 1) / 2;
+        memcpy(leaf->keys, keys, sizeof(void *) * half);
+        memcpy(leaf->counts, counts, sizeof(int) * half);
+        n->size = half;
+        memcpy(right->keys, &keys[half], sizeof(void *) * (LEAF_KEYS + 1 - half));
+        memcpy(right->counts, &counts[half], sizeof(int) * (LEAF_KEYS + 1 - half));
+        right->header.size = LEAF_KEYS + 1 - half;
+        right->next = leaf->next;
+        right->prev = leaf;
+        if (leaf->next != NULL) leaf->next->prev = right;
+        leaf->next = right;
+        *sep = right->keys[0];
+        return (BTNODE *) right;
+    }
+
+    BTINNER *inner = (BTINNER *) n;
+    int i = upperBound(t, inner->keys, n->size, v);
+    void *childSep = NULL;
+    BTNODE *child = insertInto(t, inner->children[i], v, &childSep);
+    if (child == NULL) return NULL;
+    if (n->size < INNER_KEYS) {
+        memmove(&inner->keys[i + 1], &inner->keys[i], sizeof(void *) * (n->size - i));
+        memmove(&inner->children[i + 2], &inner->children[i + 1], sizeof(BTNODE *) * (n->size - i));
+        inner->keys[i] = childSep;
+        inner->children[i + 1] = child;
+        n->size++;
+        return NULL;
+    }
+    // Node is full, split it and push the middle separator up
+    void *keys[INNER_KEYS + 1];
+    BTNODE *children[INNER_KEYS + 2];
+    memcpy(keys, inner->keys, sizeof(void *) * i);
+    memcpy(children, inner->children, sizeof(BTNODE *) * (i + 1));
+    keys[i] = childSep;
+    children[i + 1] = child;
+    memcpy(&keys[i + 1], &inner->keys[i], sizeof(void *) * (INNER_KEYS - i));
+    memcpy(&children[i + 2], &inner->children[i + 1], sizeof(BTNODE *) * (INNER_KEYS - i));
+    BTINNER *right = newBTINNER();
+    int half = (INNER_KEYS + 1) / 2;
+    memcpy(inner->keys, keys, sizeof(void *) * half);
+    memcpy(inner->children, children, sizeof(BTNODE *) * (half + 1));
+    n->size = half;
+    *sep = keys[half];
+    memcpy(right->keys, &keys[half + 1], sizeof(void *) * (INNER_KEYS - half));
+    memcpy(right->children, &children[half + 1], sizeof(BTNODE *) * (INNER_KEYS + 1 - half));
+    right->header.size = INNER_KEYS - half;
+    return (BTNODE *) right;
+}
+
+
+/*
+ *  Method (private):   deleteFrom
+ *  Usage:  int underflow = deleteFrom(t, n, v, &rv);
+ *  Description: This private method removes one occurrence of v from the
+ *  subtree rooted at n, storing the returned value in rv. It returns true
+ *  if n is left with fewer keys than the minimum, so the parent can fix it.
+ */
+int deleteFrom(BTREE *t, BTNODE *n, void *v, void **rv) {
+    if (n->leaf) {
+        BTLEAF *leaf = (BTLEAF *) n;
+        int i = lowerBound(t, leaf->keys, n->size, v);
+        if (i == n->size || t->compare(v, leaf->keys[i]) != 0) {
+            // Value not found in tree
+            return 0;
+        }
+        t->size--;
+        if (leaf->counts[i] > 1) {
+            // Value has duplicates
+            leaf->counts[i]--;
+            *rv = v;
+            return 0;
+        }
+        *rv = leaf->keys[i];
+        memmove(&leaf->keys[i], &leaf->keys[i + 1], sizeof(void *) * (n->size - i - 1));
+        memmove(&leaf->counts[i], &leaf->counts[i + 1], sizeof(int) * (n->size - i - 1));
+        n->size--;
+        t->keys--;
+        return n->size < LEAF_MIN;
+    }
+
+    BTINNER *inner = (BTINNER *) n;
+    int i = upperBound(t, inner->keys, n->size, v);
+    if (deleteFrom(t, inner->children[i], v, rv)) fixChild(inner, i);
+    return n->size < INNER_MIN;
+}
+
+
+/*
+ *  Method (private):   fixChild
+ *  Usage:  fixChild(p, i);
+ *  Description: This private method refills the underfull child i of p by
+ *  borrowing from a sibling with keys to spare, or else merging it with a
+ *  sibling.
+ */
+void fixChild(BTINNER *p, int i) {
+    BTNODE *c = p->children[i];
+    BTNODE *left = i > 0 ? p->children[i - 1] : NULL;
+    BTNODE *right = i < p->header.size ? p->children[i + 1] : NULL;
+    int min = c->leaf ? LEAF_MIN : INNER_MIN;
+    if (left != NULL && left->size > min) {
+        // Borrow the largest key of the left sibling
+        if (c->leaf) {
+            BTLEAF *cl = (BTLEAF *) c;
+            BTLEAF *ll = (BTLEAF *) left;
+            memmove(&cl->keys[1], cl->keys, sizeof(void *) * c->size);
+            memmove(&cl->counts[1], cl->counts, sizeof(int) * c->size);
+            cl->keys[0] = ll->keys[left->size - 1];
+            cl->counts[0] = ll->counts[left->size - 1];
+            p->keys[i - 1] = cl->keys[0];
+        }
+        else {
+            BTINNER *ci = (BTINNER *) c;
+            BTINNER *li = (BTINNER *) left;
+            memmove(&ci->keys[1], ci->keys, sizeof(void *) * c->size);
+            memmove(&ci->children[1], ci->children, sizeof(BTNODE *) * (c->size + 1));
+            ci->keys[0] = p->keys[i - 1];
+            ci->children[0] = li->children[left->size];
+            p->keys[i - 1] = li->keys[left->size - 1];
+        }
+        left->size--;
+        c->size++;
+    }
+    else if (right != NULL && right->size > min) {
+        // Borrow the smallest key of the right sibling
+        if (c->leaf) {
+            BTLEAF *cl = (BTLEAF *) c;
+            BTLEAF *rl = (BTLEAF *) right;
+            cl->keys[c->size] = rl->keys[0];
+            cl->counts[c->size] = rl->counts[0];
+            memmove(rl->keys, &rl->keys[1], sizeof(void *) * (right->size - 1));
+            memmove(rl->counts, &rl->counts[1], sizeof(int) * (right->size - 1));
+            p->keys[i] = rl->keys[0];
+        }
+        else {
+            BTINNER *ci = (BTINNER *) c;
+            BTINNER *ri = (BTINNER *) right;
+            ci->keys[c->size] = p->keys[i];
+            ci->children[c->size + 1] = ri->children[0];
+            p->keys[i] = ri->keys[0];
+            memmove(ri->keys, &ri->keys[1], sizeof(void *) * (right->size - 1));
+            memmove(ri->children, &ri->children[1], sizeof(BTNODE *) * right->size);
+        }
+        right->size--;
+        c->size++;
+    }
+    else if (left != NULL) mergeChildren(p, i - 1);
+    else mergeChildren(p, i);
+}
+
+
+/*
+ *  Method (private):   mergeChildren
+ *  Usage:  mergeChildren(p, i);
+ *  Description: This private method merges child i + 1 of p into child i
+ *  and removes the separator between them from p.
+ */
+void mergeChildren(BTINNER *p, int i) {
+    BTNODE *left = p->children[i];
+    BTNODE *right = p->children[i + 1];
+    if (left->leaf) {
+        BTLEAF *ll = (BTLEAF *) left;
+        BTLEAF *rl = (BTLEAF *) right;
+        memcpy(&ll->keys[left->size], rl->keys, sizeof(void *) * right->size);
+        memcpy(&ll->counts[left->size], rl->counts, sizeof(int) * right->size);
+        left->size += right->size;
+        ll->next = rl->next;
+        if (rl->next != NULL) rl->next->prev = ll;
+    }
+    else {
+        BTINNER *li = (BTINNER *) left;
+        BTINNER *ri = (BTINNER *) right;
+        li->keys[left->size] = p->keys[i];
+        memcpy(&li->keys[left->size + 1], ri->keys, sizeof(void *) * right->size);
+        memcpy(&li->children[left->size + 1], ri->children, sizeof(BTNODE *) * (right->size + 1));
+        left->size += right->size + 1;
+    }
+    free(right);
+    memmove(&p->keys[i], &p->keys[i + 1], sizeof(void *) * (p->header.size - i - 1));
+    memmove(&p->children[i + 1], &p->children[i + 2], sizeof(BTNODE *) * (p->header.size - i - 1));
+    p->header.size--;
+}
+
+
+/*
+ *  Method (private):   replaceSeparator
+ *  Usage:  replaceSeparator(t, removed);
+ *  Description: This private method keeps every separator pointing at a
+ *  value that is still in the tree, so the caller may free a removed value.
+ *  A separator equal to the removed value can only lie on its search path,
+ *  where it is replaced by the smallest value of the subtree to its right.
+ */
+void replaceSeparator(BTREE *t, void *v) {
+    BTNODE *n = t->root;
+    while (!n->leaf) {
+        BTINNER *inner = (BTINNER *) n;
+        int i = upperBound(t, inner->keys, n->size, v);
+        n = inner->children[i];
+        if (i > 0 && t->compare(inner->keys[i - 1], v) == 0) {
+            BTNODE *m = n;
+            while (!m->leaf) m = ((BTINNER *) m)->children[0];
+            inner->keys[i - 1] = ((BTLEAF *) m)->keys[0];
+            return;
+        }
+    }
+}
+
+
+/*
+ *  Method (private):   height
+ *  Usage:  int h = height(t);
+ *  Description: This private method returns the number of levels in a tree.
+ */
+int height(BTREE *t) {
+    int h = 1;
+    BTNODE *n = t->root;
+    while (!n->leaf) {
+        n = ((BTINNER *) n)->children[0];
+        h++;
+    }
+    return h;
+}
+
+
+/*
+ *  Method (private):   displayNode
+ *  Usage:  displayNode(t, n, fp);
+ *  Description: This private method displays the keys of a single node.
+ */
+void displayNode(BTREE *t, BTNODE *n, FILE *fp) {
+    fprintf(fp, "[");
+    for (int i = 0; i < n->size; i++) {
+        if (i > 0) fprintf(fp, " ");
+        if (n->leaf) {
+            t->display(((BTLEAF *) n)->keys[i], fp);
+            int count = ((BTLEAF *) n)->counts[i];
+            if (count > 1) fprintf(fp, "[%d]", count);
+        }
+        else t->display(((BTINNER *) n)->keys[i], fp);
+    }
+    fprintf(fp, "]");
+}
+
+
+/*
+ *  Method (private):   freeNodes
+ *  Usage:  freeNodes(t->root);
+ *  Description: This private method frees the nodes of a subtree. The
+ *  recursion is only as deep as the tree is tall.
+ */
+void freeNodes(BTNODE *n) {
+    if (!n->leaf) {
+        BTINNER *inner = (BTINNER *) n;
+        for (int i = 0; i <= n->size; i++) freeNodes(inner->children[i]);
+    }
+    free(n);
+}
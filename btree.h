@@ -0,0 +1,46 @@
+/*
+ *  File:   btree.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the btree module, an
+ *  ordered map stored as a B+tree of cache-line-aligned nodes. The function
+ *  set mirrors avl.h, so callers can switch between the two, and adds
+ *  ordered cursors and a bulk loader.
+ */
+
+#ifndef __BTREE_INCLUDED__
+#define __BTREE_INCLUDED__
+
+#include <stdio.h>
+
+typedef struct BTREE BTREE;
+
+extern BTREE *newBTREE(
+        void (*)(void *, FILE *),
+        int (*)(void *, void *),
+        void (*)(void *));
+extern void insertBTREE(BTREE *, void *);
+extern void loadBTREE(BTREE *, void **, int);
+extern int findBTREEcount(BTREE *, void *);
+extern void *findBTREE(BTREE *, void *);
+extern void *deleteBTREE(BTREE *, void *);
+extern int sizeBTREE(BTREE *);
+extern int duplicatesBTREE(BTREE *);
+extern void statisticsBTREE(BTREE *, FILE *);
+extern void displayBTREE(BTREE *, FILE *);
+extern void displayBTREEdebug(BTREE *, FILE *);
+extern void freeBTREE(BTREE *);
+
+typedef struct BTREECURSOR BTREECURSOR;
+
+extern BTREECURSOR *newBTREECURSOR(BTREE *);
+extern void firstBTREECURSOR(BTREECURSOR *);
+extern void lastBTREECURSOR(BTREECURSOR *);
+extern void seekBTREECURSOR(BTREECURSOR *, void *);
+extern int moreBTREECURSOR(BTREECURSOR *);
+extern void nextBTREECURSOR(BTREECURSOR *);
+extern void prevBTREECURSOR(BTREECURSOR *);
+extern void *currentBTREECURSOR(BTREECURSOR *);
+extern int currentBTREECURSORcount(BTREECURSOR *);
+extern void freeBTREECURSOR(BTREECURSOR *);
+
+#endif // !__BTREE_INCLUDED__
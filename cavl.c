@@ -0,0 +1,551 @@
+/*
+ *  File:   cavl.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the cavl module. Nodes
+ *  are never changed once published. A write copies the nodes on its path
+ *  (and any it rotates), stamping the copies with the new version, so the
+ *  copies can be modified freely until the new snapshot is swapped in. The
+ *  replaced nodes are retired to the epoch reclaimer only after the swap,
+ *  since until then a newly arriving reader can still reach them.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "cavl.h"
+#include "epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <assert.h>
+
+
+/*
+ *  Type:   CNODE
+ *  Description: This is a tree node, tagged with the version that made it.
+ */
+typedef struct cnode {
+    void *value;
+    int count;
+    int height;
+    long version;
+    struct cnode *left;
+    struct cnode *right;
+} CNODE;
+
+
+/*
+ *  Type:   SNAPSHOT
+ *  Description: This is one published version of the tree.
+ */
+typedef struct snapshot {
+    CNODE *root;
+    long version;
+    int size;
+    int nodes;
+} SNAPSHOT;
+
+
+// CAVL private method prototypes
+static CNODE *newCNODE(CAVL *t, void *v);
+static CNODE *own(CAVL *t, CNODE *n);
+static void discard(CAVL *t, CNODE *n);
+static int height(CNODE *n);
+static void setHeight(CNODE *n);
+static CNODE *rotateLeft(CAVL *t, CNODE *x);
+static CNODE *rotateRight(CAVL *t, CNODE *x);
+static CNODE *balance(CAVL *t, CNODE *x);
+static CNODE *insertNode(CAVL *t, CNODE *n, void *v, int *added);
+static CNODE *deleteNode(CAVL *t, CNODE *n, void *v, void **rv, int *removed);
+static CNODE *removeMinimum(CAVL *t, CNODE *n, CNODE **min);
+static CNODE *search(CAVL *t, int reader, void *v, int *count);
+static void publish(CAVL *t, CNODE *root, int size, int nodes);
+static void displayNodes(CAVL *t, CNODE *n, FILE *fp, int *first);
+static void freeNodes(CAVL *t, CNODE *n);
+
+
+/*
+ *  Type:   CAVL
+ *  Description: This is the struct definition for the CAVL class. The
+ *  fields after the lock belong to the writer holding it.
+ */
+struct CAVL {
+    _Atomic(SNAPSHOT *) current;
+    EPOCH *epoch;
+    void (*display)(void *, FILE *);
+    int (*compare)(void *, void *);
+    void (*free)(void *);
+    pthread_mutex_t lock;
+    int writer;
+    long writing;
+    CNODE **pending;
+    int pendingSize;
+    int pendingCapacity;
+};
+
+
+/*
+ *  Constructor: newCAVL
+ *  Usage:  CAVL *t = newCAVL(displayVERTEX, compareVERTEX, freeVERTEX);
+ *  Description: This is the constructor used to instantiate a new CAVL
+ *  object. It starts with an empty snapshot at version zero.
+ */
+CAVL *newCAVL(
+        void (*d)(void *, FILE *),
+        int (*c)(void *, void *),
+        void (*f)(void *)) {
+    CAVL *t = malloc(sizeof(CAVL));
+    assert(t != 0);
+    SNAPSHOT *s = malloc(sizeof(SNAPSHOT));
+    assert(s != 0);
+    s->root = NULL;
+    s->version = 0;
+    s->size = 0;
+    s->nodes = 0;
+    atomic_init(&t->current, s);
+    t->epoch = newEPOCH();
+    t->display = d;
+    t->compare = c;
+    t->free = f;
+    pthread_mutex_init(&t->lock, NULL);
+    t->writer = registerEPOCH(t->epoch);
+    t->writing = 0;
+    t->pendingCapacity = 64;
+    t->pendingSize = 0;
+    t->pending = malloc(sizeof(CNODE *) * t->pendingCapacity);
+    assert(t->pending != 0);
+    return t;
+}
+
+
+/*
+ *  Method: registerCAVL
+ *  Usage:  int reader = registerCAVL(t);
+ *  Description: This method returns a reader handle for the calling thread,
+ *  to be passed to findCAVL and findCAVLcount.
+ */
+int registerCAVL(CAVL *t) {
+    assert(t != 0);
+    return registerEPOCH(t->epoch);
+}
+
+
+/*
+ *  Method: insertCAVL
+ *  Usage:  insertCAVL(t, value);
+ *  Description: This method inserts a value, or increments its count if it
+ *  is already present, and publishes the result as a new version. Writers
+ *  are serialized; readers are never blocked. This method runs in
+ *  logarithmic time.
+ */
+void insertCAVL(CAVL *t, void *v) {
+    assert(t != 0);
+    pthread_mutex_lock(&t->lock);
+    SNAPSHOT *s = atomic_load(&t->current);
+    t->writing = s->version + 1;
+    int added = 0;
+    CNODE *root = insertNode(t, s->root, v, &added);
+    publish(t, root, s->size + 1, s->nodes + added);
+    pthread_mutex_unlock(&t->lock);
+}
+
+
+/*
+ *  Method: deleteCAVL
+ *  Usage:  void *removed = deleteCAVL(t, value);
+ *  Description: This method removes one occurrence of a value and publishes
+ *  the result, returning what deleteAVL would. Readers of older versions
+ *  may still see the value, so it must not be freed until they are done.
+ */
+void *deleteCAVL(CAVL *t, void *v) {
+    assert(t != 0);
+    pthread_mutex_lock(&t->lock);
+    SNAPSHOT *s = atomic_load(&t->current);
+    t->writing = s->version + 1;
+    void *rv = NULL;
+    int removed = 0;
+    CNODE *root = deleteNode(t, s->root, v, &rv, &removed);
+    if (rv != NULL) publish(t, root, s->size - 1, s->nodes - removed);
+    pthread_mutex_unlock(&t->lock);
+    return rv;
+}
+
+
+/*
+ *  Method: findCAVLcount
+ *  Usage:  int count = findCAVLcount(t, reader, value);
+ *  Description: This method returns the count of a value in the current
+ *  version, or zero. It never blocks.
+ */
+int findCAVLcount(CAVL *t, int reader, void *v) {
+    assert(t != 0);
+    int count = 0;
+    search(t, reader, v, &count);
+    return count;
+}
+
+
+/*
+ *  Method: findCAVL
+ *  Usage:  void *found = findCAVL(t, reader, value);
+ *  Description: This method returns the stored value equal to the given
+ *  value in the current version, or NULL. It never blocks.
+ */
+void *findCAVL(CAVL *t, int reader, void *v) {
+    assert(t != 0);
+    int count = 0;
+    CNODE *n = search(t, reader, v, &count);
+    return n == NULL ? NULL : n->value;
+}
+
+
+/*
+ *  Method: sizeCAVL
+ *  Usage:  int s = sizeCAVL(t);
+ *  Description: This method returns the number of distinct values in the
+ *  current version.
+ */
+int sizeCAVL(CAVL *t) {
+    assert(t != 0);
+    return atomic_load(&t->current)->nodes;
+}
+
+
+/*
+ *  Method: duplicatesCAVL
+ *  Usage:  int d = duplicatesCAVL(t);
+ *  Description: This method returns the number of duplicate insertions in
+ *  the current version.
+ */
+int duplicatesCAVL(CAVL *t) {
+    assert(t != 0);
+    SNAPSHOT *s = atomic_load(&t->current);
+    return s->size - s->nodes;
+}
+
+
+/*
+ *  Method: versionCAVL
+ *  Usage:  long version = versionCAVL(t);
+ *  Description: This method returns the version of the current snapshot,
+ *  which goes up by one with every successful write.
+ */
+long versionCAVL(CAVL *t) {
+    assert(t != 0);
+    return atomic_load(&t->current)->version;
+}
+
+
+/*
+ *  Method: displayCAVL
+ *  Usage:  displayCAVL(t, stdout);
+ *  Description: This method displays the current version in order, with
+ *  counts above one shown after a value. It must not run concurrently with
+ *  a writer.
+ *  Example Output:
+ *                  [2 4[2] 5]
+ */
+void displayCAVL(CAVL *t, FILE *fp) {
+    assert(t != 0);
+    int first = 1;
+    fprintf(fp, "[");
+    displayNodes(t, atomic_load(&t->current)->root, fp, &first);
+    fprintf(fp, "]");
+}
+
+
+/*
+ *  Method: freeCAVL
+ *  Usage:  freeCAVL(t);
+ *  Description: This method frees the current version (and its values, if
+ *  there is a freeing function), every retired node, and the tree itself.
+ *  No thread may be using the tree.
+ */
+void freeCAVL(CAVL *t) {
+    assert(t != 0);
+    SNAPSHOT *s = atomic_load(&t->current);
+    freeNodes(t, s->root);
+    free(s);
+    freeEPOCH(t->epoch);
+    pthread_mutex_destroy(&t->lock);
+    free(t->pending);
+    free(t);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Constructor (private): newCNODE
+ *  Usage:  CNODE *n = newCNODE(t, value);
+ *  Description: This private constructor returns a leaf of the version
+ *  being written.
+ */
+CNODE *newCNODE(CAVL *t, void *v) {
+    CNODE *n = malloc(sizeof(CNODE));
+    assert(n != 0);
+    n->value = v;
+    n->count = 1;
+    n->height = 1;
+    n->version = t->writing;
+    n->left = NULL;
+    n->right = NULL;
+    return n;
+}
+
+
+/*
+ *  Method (private):   own
+ *  Usage:  CNODE *x = own(t, n);
+ *  Description: This private method returns a node of the version being
+ *  written that may be modified in place of n. A published node is copied
+ *  and the original set aside for retirement.
+ */
+CNODE *own(CAVL *t, CNODE *n) {
+    if (n->version == t->writing) return n;
+    CNODE *x = malloc(sizeof(CNODE));
+    assert(x != 0);
+    *x = *n;
+    x->version = t->writing;
+    discard(t, n);
+    return x;
+}
+
+
+/*
+ *  Method (private):   discard
+ *  Usage:  discard(t, n);
+ *  Description: This private method drops a node from the version being
+ *  written. Unpublished nodes are freed at once; published ones wait in
+ *  the pending list until the new version has been swapped in.
+ */
+void discard(CAVL *t, CNODE *n) {
+    if (n->version == t->writing) {
+        free(n);
+        return;
+    }
+    if (t->pendingSize == t->pendingCapacity) {
+        t->pendingCapacity *= 2;
+        t->pending = realloc(t->pending, sizeof(CNODE *) * t->pendingCapacity);
+        assert(t->pending != 0);
+    }
+    t->pending[t->pendingSize++] = n;
+}
+
+
+int height(CNODE *n) {
+    return n == NULL ? 0 : n->height;
+}
+
+
+void setHeight(CNODE *n) {
+    int lh = height(n->left);
+    int rh = height(n->right);
+    n->height = lh > rh ? lh + 1 : rh + 1;
+}
+
+
+/*
+ *  Method (private):   rotateLeft
+ *  Usage:  x = rotateLeft(t, x);
+ *  Description: This private method rotates the owned node x with its
+ *  right child, which is owned first, and returns the new subtree root.
+ */
+CNODE *rotateLeft(CAVL *t, CNODE *x) {
+    CNODE *y = own(t, x->right);
+    x->right = y->left;
+    y->left = x;
+    setHeight(x);
+    setHeight(y);
+    return y;
+}
+
+
+/*
+ *  Method (private):   rotateRight
+ *  Usage:  x = rotateRight(t, x);
+ *  Description: This private method is the mirror image of rotateLeft.
+ */
+CNODE *rotateRight(CAVL *t, CNODE *x) {
+    CNODE *y = own(t, x->left);
+    x->left = y->right;
+    y->right = x;
+    setHeight(x);
+    setHeight(y);
+    return y;
+}
+
+
+/*
+ *  Method (private):   balance
+ *  Usage:  x = balance(t, x);
+ *  Description: This private method restores the AVL property at the owned
+ *  node x, whose subtrees differ in height by at most two.
+ */
+CNODE *balance(CAVL *t, CNODE *x) {
+    setHeight(x);
+    int bal = height(x->left) - height(x->right);
+    if (bal > 1) {
+        if (height(x->left->left) < height(x->left->right)) {
+            x->left = rotateLeft(t, own(t, x->left));
+        }
+        return rotateRight(t, x);
+    }
+    if (bal < -1) {
+        if (height(x->right->right) < height(x->right->left)) {
+            x->right = rotateRight(t, own(t, x->right));
+        }
+        return rotateLeft(t, x);
+    }
+    return x;
+}
+
+
+/*
+ *  Method (private):   insertNode
+ *  Usage:  root = insertNode(t, root, value, &added);
+ *  Description: This private method returns the path-copied subtree with v
+ *  inserted, setting added if a new node was made.
+ */
+CNODE *insertNode(CAVL *t, CNODE *n, void *v, int *added) {
+    if (n == NULL) {
+        *added = 1;
+        return newCNODE(t, v);
+    }
+    int c = t->compare(v, n->value);
+    CNODE *x = own(t, n);
+    if (c == 0) {
+        // Tree already contains the value
+        x->count++;
+        return x;
+    }
+    if (c < 0) x->left = insertNode(t, x->left, v, added);
+    else x->right = insertNode(t, x->right, v, added);
+    return balance(t, x);
+}
+
+
+/*
+ *  Method (private):   deleteNode
+ *  Usage:  root = deleteNode(t, root, value, &rv, &removed);
+ *  Description: This private method returns the path-copied subtree with
+ *  one occurrence of v removed. Nothing is copied if v is absent.
+ */
+CNODE *deleteNode(CAVL *t, CNODE *n, void *v, void **rv, int *removed) {
+    if (n == NULL) return NULL;
+    int c = t->compare(v, n->value);
+    if (c != 0) {
+        CNODE *child = c < 0 ? n->left : n->right;
+        CNODE *replacement = deleteNode(t, child, v, rv, removed);
+        if (*rv == NULL) return n;
+        CNODE *x = own(t, n);
+        if (c < 0) x->left = replacement;
+        else x->right = replacement;
+        return balance(t, x);
+    }
+    if (n->count > 1) {
+        // Value has duplicates
+        CNODE *x = own(t, n);
+        x->count--;
+        *rv = v;
+        return x;
+    }
+    *rv = n->value;
+    *removed = 1;
+    if (n->left == NULL || n->right == NULL) {
+        CNODE *child = n->left == NULL ? n->right : n->left;
+        discard(t, n);
+        return child;
+    }
+    // Replace the value with its successor's
+    CNODE *min = NULL;
+    CNODE *x = own(t, n);
+    x->right = removeMinimum(t, x->right, &min);
+    x->value = min->value;
+    x->count = min->count;
+    discard(t, min);
+    return balance(t, x);
+}
+
+
+/*
+ *  Method (private):   removeMinimum
+ *  Usage:  root = removeMinimum(t, root, &min);
+ *  Description: This private method unlinks the smallest node of a subtree,
+ *  storing it in min, and returns the path-copied remainder.
+ */
+CNODE *removeMinimum(CAVL *t, CNODE *n, CNODE **min) {
+    if (n->left == NULL) {
+        *min = n;
+        return n->right;
+    }
+    CNODE *x = own(t, n);
+    x->left = removeMinimum(t, x->left, min);
+    return balance(t, x);
+}
+
+
+/*
+ *  Method (private):   search
+ *  Usage:  CNODE *n = search(t, reader, value, &count);
+ *  Description: This private method looks v up in the current snapshot
+ *  inside an epoch, so no node it visits can be freed under it.
+ */
+CNODE *search(CAVL *t, int reader, void *v, int *count) {
+    enterEPOCH(t->epoch, reader);
+    SNAPSHOT *s = atomic_load_explicit(&t->current, memory_order_acquire);
+    CNODE *n = s->root;
+    while (n != NULL) {
+        int c = t->compare(v, n->value);
+        if (c == 0) {
+            *count = n->count;
+            break;
+        }
+        n = c < 0 ? n->left : n->right;
+    }
+    exitEPOCH(t->epoch, reader);
+    return n;
+}
+
+
+/*
+ *  Method (private):   publish
+ *  Usage:  publish(t, root, size, nodes);
+ *  Description: This private method swaps in a new snapshot and only then
+ *  retires the old snapshot and the nodes the write replaced.
+ */
+void publish(CAVL *t, CNODE *root, int size, int nodes) {
+    SNAPSHOT *s = malloc(sizeof(SNAPSHOT));
+    assert(s != 0);
+    s->root = root;
+    s->version = t->writing;
+    s->size = size;
+    s->nodes = nodes;
+    SNAPSHOT *old = atomic_exchange_explicit(&t->current, s, memory_order_acq_rel);
+    retireEPOCH(t->epoch, t->writer, old, free);
+    for (int i = 0; i < t->pendingSize; i++) {
+        retireEPOCH(t->epoch, t->writer, t->pending[i], free);
+    }
+    t->pendingSize = 0;
+}
+
+
+void displayNodes(CAVL *t, CNODE *n, FILE *fp, int *first) {
+    if (n == NULL) return;
+    displayNodes(t, n->left, fp, first);
+    if (!*first) fprintf(fp, " ");
+    t->display(n->value, fp);
+    if (n->count > 1) fprintf(fp, "[%d]", n->count);
+    *first = 0;
+    displayNodes(t, n->right, fp, first);
+}
+
+
+void freeNodes(CAVL *t, CNODE *n) {
+    if (n == NULL) return;
+    freeNodes(t, n->left);
+    freeNodes(t, n->right);
+    if (t->free != NULL) t->free(n->value);
+    free(n);
+}
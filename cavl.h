@@ -0,0 +1,33 @@
+/*
+ *  File:   cavl.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the cavl module, a
+ *  read-mostly concurrent AVL tree. Readers search an immutable snapshot
+ *  without taking locks; writers build a path-copied snapshot and publish
+ *  it atomically. Each reading thread needs its own handle from
+ *  registerCAVL.
+ */
+
+#ifndef __CAVL_INCLUDED__
+#define __CAVL_INCLUDED__
+
+#include <stdio.h>
+
+typedef struct CAVL CAVL;
+
+extern CAVL *newCAVL(
+        void (*)(void *, FILE *),
+        int (*)(void *, void *),
+        void (*)(void *));
+extern int registerCAVL(CAVL *);
+extern void insertCAVL(CAVL *, void *);
+extern void *deleteCAVL(CAVL *, void *);
+extern int findCAVLcount(CAVL *, int, void *);
+extern void *findCAVL(CAVL *, int, void *);
+extern int sizeCAVL(CAVL *);
+extern int duplicatesCAVL(CAVL *);
+extern long versionCAVL(CAVL *);
+extern void displayCAVL(CAVL *, FILE *);
+extern void freeCAVL(CAVL *);
+
+#endif // !__CAVL_INCLUDED__
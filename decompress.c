@@ -0,0 +1,307 @@
+/*
+ *  File:   decompress.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the decompress module.
+ *  The helper thread takes the borrowed input bytes first and then reads
+ *  the file descriptor, if there is one, to its end, sending what it
+ *  decompresses down one end of a socket pair. A socket is used rather
+ *  than a pipe so that a helper whose reader has gone away gets an error
+ *  from send() instead of a SIGPIPE. For the same reason the helper waits
+ *  for input with poll() on its end of the socket too, so a reader that
+ *  goes away also wakes a helper blocked on a pipe that is still open.
+ *  Concatenated gzip members are read
+ *  one after another, as gzip -d does. zstd needs libzstd, so it is only
+ *  compiled in when HAVE_ZSTD is defined.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "decompress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define INPUT_SIZE (1 << 20)    /* compressed bytes taken at a time */
+#define OUTPUT_SIZE (1 << 18)   /* plain bytes sent at a time */
+#define SOCKET_BUFFER (1 << 20) /* plain bytes in flight to the reader */
+
+
+// DECOMPRESSOR private method prototypes
+static void *run(void *arg);
+static long fetch(DECOMPRESSOR *d, char **bytes);
+static int deliver(DECOMPRESSOR *d, char *bytes, long size);
+static void gunzip(DECOMPRESSOR *d);
+#ifdef HAVE_ZSTD
+static void unzstd(DECOMPRESSOR *d);
+#endif
+static void decompressError(char *problem);
+
+
+/*
+ *  Type:   DECOMPRESSOR
+ *  Description: This is the struct definition for the DECOMPRESSOR class.
+ *  The caller reads sockets[0] and the helper writes sockets[1].
+ */
+struct DECOMPRESSOR {
+    int format;
+    char *input;
+    long size;
+    int fd;
+    char *buffer;
+    int sockets[2];
+    pthread_t helper;
+};
+
+
+/*
+ *  Method: formatDECOMPRESSOR
+ *  Usage:  int format = formatDECOMPRESSOR(bytes, size);
+ *  Description: This method returns the format whose magic number starts
+ *  bytes, or DECOMPRESS_NONE.
+ */
+int formatDECOMPRESSOR(char *bytes, long size) {
+    unsigned char *b = (unsigned char *) bytes;
+    if (size >= 2 && b[0] == 0x1f && b[1] == 0x8b) return DECOMPRESS_GZIP;
+    if (size >= 4 && b[0] == 0x28 && b[1] == 0xb5 && b[2] == 0x2f && b[3] == 0xfd) {
+        return DECOMPRESS_ZSTD;
+    }
+    return DECOMPRESS_NONE;
+}
+
+
+/*
+ *  Constructor: newDECOMPRESSOR
+ *  Usage:  DECOMPRESSOR *d = newDECOMPRESSOR(DECOMPRESS_GZIP, head, 4, fd);
+ *  Description: This is the constructor used to start decompressing the
+ *  given input bytes followed by everything read from fd, which may be -1
+ *  if the input bytes are the whole file. The input bytes are borrowed and
+ *  must outlive the DECOMPRESSOR; fd is not closed. A format this build
+ *  cannot read, or a helper that cannot be started, is reported on stderr
+ *  and the program exits.
+ */
+DECOMPRESSOR *newDECOMPRESSOR(int format, char *input, long size, int fd) {
+    assert(format != DECOMPRESS_NONE);
+#ifndef HAVE_ZSTD
+    if (format == DECOMPRESS_ZSTD) decompressError("zstd input needs a build with HAVE_ZSTD");
+#endif
+    DECOMPRESSOR *d = malloc(sizeof(DECOMPRESSOR));
+    assert(d != 0);
+    d->format = format;
+    d->input = input;
+    d->size = size;
+    d->fd = fd;
+    d->buffer = fd >= 0 ? malloc(INPUT_SIZE) : NULL;
+    assert(fd < 0 || d->buffer != 0);
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, d->sockets) != 0) {
+        decompressError(strerror(errno));
+    }
+    int room = SOCKET_BUFFER;
+    setsockopt(d->sockets[1], SOL_SOCKET, SO_SNDBUF, &room, sizeof(room));
+    setsockopt(d->sockets[0], SOL_SOCKET, SO_RCVBUF, &room, sizeof(room));
+    if (pthread_create(&d->helper, NULL, run, d) != 0) {
+        decompressError("could not start the helper thread");
+    }
+    return d;
+}
+
+
+/*
+ *  Method: fdDECOMPRESSOR
+ *  Usage:  int fd = fdDECOMPRESSOR(d);
+ *  Description: This method returns the descriptor the plain bytes are
+ *  read from. It reaches the end of file after the last of them.
+ */
+int fdDECOMPRESSOR(DECOMPRESSOR *d) {
+    assert(d != 0);
+    return d->sockets[0];
+}
+
+
+/*
+ *  Method: freeDECOMPRESSOR
+ *  Usage:  freeDECOMPRESSOR(d);
+ *  Description: This method closes the reading end, which stops a helper
+ *  that is still sending or still waiting for input, waits for the helper
+ *  and frees the object.
+ */
+void freeDECOMPRESSOR(DECOMPRESSOR *d) {
+    assert(d != 0);
+    close(d->sockets[0]);
+    pthread_join(d->helper, NULL);
+    free(d->buffer);
+    free(d);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   run
+ *  Usage:  pthread_create(&d->helper, NULL, run, d);
+ *  Description: This private method is the body of the helper thread.
+ *  Closing the sending end tells the reader the plain bytes are over.
+ */
+void *run(void *arg) {
+    DECOMPRESSOR *d = arg;
+#ifdef HAVE_ZSTD
+    if (d->format == DECOMPRESS_ZSTD) unzstd(d);
+    else gunzip(d);
+#else
+    gunzip(d);
+#endif
+    close(d->sockets[1]);
+    return NULL;
+}
+
+
+/*
+ *  Method (private):   fetch
+ *  Usage:  long n = fetch(d, &bytes);
+ *  Description: This private method points bytes at the next piece of
+ *  compressed input and returns its length, zero at the end, or -1 if the
+ *  reader has gone away while the helper waited for input.
+ */
+long fetch(DECOMPRESSOR *d, char **bytes) {
+    if (d->size > 0) {
+        long n = d->size < INPUT_SIZE ? d->size : INPUT_SIZE;
+        *bytes = d->input;
+        d->input += n;
+        d->size -= n;
+        return n;
+    }
+    if (d->fd < 0) return 0;
+    while (1) {
+        // Closing the reading end hangs up the helper's end of the socket
+        struct pollfd ready[2] = { { d->fd, POLLIN, 0 }, { d->sockets[1], 0, 0 } };
+        if (poll(ready, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "READ ERROR: %s\n", strerror(errno));
+            exit(1);
+        }
+        if (ready[1].revents & (POLLHUP | POLLERR)) return -1;
+        if (ready[0].revents == 0) continue;
+        ssize_t n = read(d->fd, d->buffer, INPUT_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            fprintf(stderr, "READ ERROR: %s\n", strerror(errno));
+            exit(1);
+        }
+        *bytes = d->buffer;
+        return n;
+    }
+}
+
+
+/*
+ *  Method (private):   deliver
+ *  Usage:  if (!deliver(d, out, n)) return;
+ *  Description: This private method sends plain bytes to the reader,
+ *  returning false if the reader has gone away.
+ */
+int deliver(DECOMPRESSOR *d, char *bytes, long size) {
+    while (size > 0) {
+        ssize_t n = send(d->sockets[1], bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return 0;
+        bytes += n;
+        size -= n;
+    }
+    return 1;
+}
+
+
+/*
+ *  Method (private):   gunzip
+ *  Usage:  gunzip(d);
+ *  Description: This private method decompresses gzip input with zlib.
+ */
+void gunzip(DECOMPRESSOR *d) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // 16 asks zlib for the gzip wrapper rather than the zlib one
+    if (inflateInit2(&z, 15 + 16) != Z_OK) decompressError("zlib could not start");
+    char *out = malloc(OUTPUT_SIZE);
+    assert(out != 0);
+    int complete = 0;
+    int running = 1;
+    char *bytes;
+    long n = 0;
+    while (running && (n = fetch(d, &bytes)) > 0) {
+        z.next_in = (Bytef *) bytes;
+        z.avail_in = n;
+        do {
+            z.next_out = (Bytef *) out;
+            z.avail_out = OUTPUT_SIZE;
+            int r = inflate(&z, Z_NO_FLUSH);
+            if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+                decompressError(z.msg ? z.msg : "damaged gzip input");
+            }
+            if (r != Z_BUF_ERROR) complete = r == Z_STREAM_END;
+            if (r == Z_STREAM_END) inflateReset(&z);
+            running = deliver(d, out, OUTPUT_SIZE - z.avail_out);
+        } while (running && (z.avail_in > 0 || z.avail_out == 0));
+    }
+    if (n < 0) running = 0;
+    if (running && !complete) decompressError("gzip input is truncated");
+    inflateEnd(&z);
+    free(out);
+}
+
+
+#ifdef HAVE_ZSTD
+/*
+ *  Method (private):   unzstd
+ *  Usage:  unzstd(d);
+ *  Description: This private method decompresses zstd input with libzstd.
+ */
+void unzstd(DECOMPRESSOR *d) {
+    ZSTD_DStream *z = ZSTD_createDStream();
+    if (z == NULL) decompressError("libzstd could not start");
+    ZSTD_initDStream(z);
+    char *out = malloc(OUTPUT_SIZE);
+    assert(out != 0);
+    size_t remaining = 0;
+    int running = 1;
+    char *bytes;
+    long n = 0;
+    while (running && (n = fetch(d, &bytes)) > 0) {
+        ZSTD_inBuffer in = { bytes, n, 0 };
+        ZSTD_outBuffer o;
+        do {
+            o.dst = out;
+            o.size = OUTPUT_SIZE;
+            o.pos = 0;
+            remaining = ZSTD_decompressStream(z, &o, &in);
+            if (ZSTD_isError(remaining)) decompressError((char *) ZSTD_getErrorName(remaining));
+            running = deliver(d, out, o.pos);
+        } while (running && (in.pos < in.size || o.pos == o.size));
+    }
+    if (n < 0) running = 0;
+    // A nonzero hint means the last frame is still waiting for input
+    if (running && remaining != 0) decompressError("zstd input is truncated");
+    ZSTD_freeDStream(z);
+    free(out);
+}
+#endif
+
+
+/*
+ *  Method (private):   decompressError
+ *  Usage:  decompressError("gzip input is truncated");
+ *  Description: This private method reports undecodable input, then exits.
+ */
+void decompressError(char *problem) {
+    fprintf(stderr, "DECOMPRESSION ERROR: %s\n", problem);
+    exit(1);
+}
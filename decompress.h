@@ -0,0 +1,27 @@
+/*
+ *  File:   decompress.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the decompress module,
+ *  which turns gzip or zstd input back into plain bytes on a helper thread.
+ *  The plain bytes are read from a file descriptor like any other stream,
+ *  so decompression overlaps with whatever is reading them.
+ */
+
+#ifndef __DECOMPRESS_INCLUDED__
+#define __DECOMPRESS_INCLUDED__
+
+/* input formats, told apart by their magic numbers */
+#define DECOMPRESS_NONE 0
+#define DECOMPRESS_GZIP 1
+#define DECOMPRESS_ZSTD 2
+
+#define DECOMPRESS_MAGIC 4  /* bytes needed to recognize a format */
+
+typedef struct DECOMPRESSOR DECOMPRESSOR;
+
+extern int formatDECOMPRESSOR(char *bytes, long size);
+extern DECOMPRESSOR *newDECOMPRESSOR(int format, char *input, long size, int fd);
+extern int fdDECOMPRESSOR(DECOMPRESSOR *d);
+extern void freeDECOMPRESSOR(DECOMPRESSOR *d);
+
+#endif // !__DECOMPRESS_INCLUDED__
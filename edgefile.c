@@ -0,0 +1,1149 @@
+/*
+ *  File:   edgefile.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the edgefile module.
+ *  Regular files are mapped read-only. Anything else, such as a pipe or
+ *  stdin, is streamed through a buffer that is only ever read forward: the
+ *  tokenizer's end is kept just past the last semicolon in the buffer, so
+ *  it only sees whole records, and when it gets there the partial record
+ *  after it is moved to the front and the buffer refilled. Either way the
+ *  tokenizer walks one contiguous run of bytes. Input that starts with a
+ *  gzip or zstd magic number is streamed out of a decompressor instead,
+ *  which runs on its own thread.
+ *
+ *  Batches are parsed a window of bytes at a time, in four steps: the
+ *  window is classified into bit masks of digits, signs, semicolons and
+ *  whitespace with vector compares; the token and record boundaries are
+ *  found from the masks with bit operations; all the digit runs are
+ *  converted to integers with vector multiply-adds; and the triples are
+ *  put together. A window always starts at a record, and anything the
+ *  fast path does not expect (a stray character, a missing field, a very
+ *  long number) sends that record through the scalar tokenizer instead,
+ *  which either reads it or reports the error.
+ *
+ *  Errors are reported by byte offset, line and column. Only the offset is
+ *  kept as the tokenizer goes, and it costs nothing: a mapped file's offset
+ *  is a pointer difference, and a stream adds the bytes it has moved out of
+ *  its buffer. Lines are counted only when an error is reported, from the
+ *  last position counted up to the error, so skipping many bad records
+ *  counts each byte once. A stream cannot go back for bytes it has let go,
+ *  so refill counts the lines in them on the way out.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "edgefile.h"
+#include "decompress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#define WINDOW 1024                 /* bytes classified at once */
+#define WORDS (WINDOW / 64)         /* mask words per window */
+#define RECORDS (WINDOW / 4)        /* most records in a window ("1 2;") */
+#define TOKENS (WINDOW / 2)         /* most tokens in a window */
+#define LONGEST 16                  /* most digits converted in bulk */
+#define STREAM_BUFFER (1 << 22)     /* bytes a stream is first read into */
+#define STREAM_READ (1 << 20)       /* most bytes a stream reads at once */
+
+
+/*
+ *  Type:   MASKS
+ *  Description: This is the classification of a window, one bit per byte.
+ */
+typedef struct masks {
+    uint64_t digit[WORDS];
+    uint64_t sign[WORDS];
+    uint64_t semi[WORDS];
+    uint64_t space[WORDS];
+} MASKS;
+
+
+/*
+ *  Type:   TOKENS
+ *  Description: This is the list of digit runs in a window, and how many
+ *  of them each record has.
+ */
+typedef struct tokenlist {
+    int count;
+    short start[TOKENS];
+    char length[TOKENS];
+    char negative[TOKENS];
+    int value[TOKENS];
+    char fields[RECORDS];
+} TOKENLIST;
+
+
+/*
+ *  Type:   BADRECORD
+ *  Description: This is a malformed record found by a parallel read, kept
+ *  so that the records skipped can be logged in file order.
+ */
+typedef struct badrecord {
+    long offset;
+    char *expected;
+} BADRECORD;
+
+
+/*
+ *  Type:   CHUNK
+ *  Description: This is one thread's share of a parallel read: a view of
+ *  its byte range, and the records parsed from it.
+ */
+typedef struct chunk {
+    EDGEFILE *view;
+    EDGETRIPLE *edges;
+    long count;
+    long capacity;
+} CHUNK;
+
+
+// EDGEFILE private method prototypes
+static EDGEFILE *newBlank(void);
+static EDGEFILE *newStream(int fd);
+static void decompress(EDGEFILE *f, int format, char *input, long size, int fd);
+static int refill(EDGEFILE *f);
+static int scanRecord(EDGEFILE *f, int *u, int *v, int *weight);
+static int scanFields(EDGEFILE *f, int *u, int *v, int *weight);
+static void skipRecord(EDGEFILE *f);
+static void logSkipped(EDGEFILE *f, long offset, char *expected);
+static int scanBatch(EDGEFILE *f, EDGETRIPLE *batch, int max);
+static void *parseChunk(void *arg);
+static int isSpace(char c);
+static void skipSpace(EDGEFILE *f);
+static int scanInt(EDGEFILE *f, int *x);
+static void scanError(EDGEFILE *f, char *expected);
+static long offsetOf(EDGEFILE *f, char *p);
+static void position(EDGEFILE *f, long offset, long *line, long *column);
+static void countLines(EDGEFILE *f, char *to);
+static int bestLevel(void);
+static void assemble(TOKENLIST *t, int records, EDGETRIPLE *out);
+#ifdef __x86_64__
+static int windowSSE42(char *p, EDGETRIPLE *out, int *used);
+static int windowAVX2(char *p, EDGETRIPLE *out, int *used);
+#endif
+
+
+/*
+ *  Type:   EDGEFILE
+ *  Description: This is the struct definition for the EDGEFILE class. The
+ *  tokenizer works from next up to end; a stream's buffer also holds the
+ *  bytes from end up to filled, which are the start of a partial record.
+ *  A stream reads fd, which is the decompressor's output when the input
+ *  descriptor holds compressed bytes, and consumed is the number of bytes
+ *  it has moved out of the front of its buffer. Lines have been counted
+ *  up to the offset counted, which lies on line lines + 1, starting at
+ *  the offset lineStart. A view taking part in a parallel read defers its
+ *  skipped records instead of logging them.
+ */
+struct EDGEFILE {
+    char *data;
+    char *next;
+    char *end;
+    char *filled;
+    long size;
+    long capacity;
+    int mapped;
+    int stream;
+    int ended;
+    int fd;
+    int input;
+    int closeFd;
+    DECOMPRESSOR *inflater;
+    char *source;
+    long sourceSize;
+    char head[DECOMPRESS_MAGIC];
+    int simd;
+    char *expected;
+    long consumed;
+    long counted;
+    long lines;
+    long lineStart;
+    int policy;
+    long skipped;
+    int defer;
+    BADRECORD *deferred;
+    long deferredCount;
+    long deferredCapacity;
+};
+
+
+/*
+ *  Constructor: newEDGEFILE
+ *  Usage:  EDGEFILE *f = newEDGEFILE("graph.data");
+ *  Description: This is the constructor used to instantiate a new EDGEFILE
+ *  object. It returns NULL if the file cannot be opened or read.
+ */
+EDGEFILE *newEDGEFILE(char *filename) {
+    int standardInput = strcmp(filename, "-") == 0;
+    int fd = standardInput ? STDIN_FILENO : open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (!standardInput && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            close(fd);
+            posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+            int format = formatDECOMPRESSOR(p, st.st_size);
+            if (format != DECOMPRESS_NONE) {
+                EDGEFILE *f = newStream(-1);
+                f->source = p;
+                f->sourceSize = st.st_size;
+                decompress(f, format, p, st.st_size, -1);
+                return f;
+            }
+            EDGEFILE *f = newBlank();
+            f->data = p;
+            f->size = st.st_size;
+            f->mapped = 1;
+            f->next = f->data;
+            f->end = f->filled = f->data + f->size;
+            return f;
+        }
+    }
+    EDGEFILE *f = newEDGEFILEstream(fd);
+    f->closeFd = !standardInput;
+    return f;
+}
+
+
+/*
+ *  Constructor: newEDGEFILEstream
+ *  Usage:  EDGEFILE *f = newEDGEFILEstream(STDIN_FILENO);
+ *  Description: This constructor reads records from an open file
+ *  descriptor with read() alone, so it works on pipes and never seeks.
+ *  The first few bytes are read straight away to check for compression.
+ *  The descriptor is left open when the EDGEFILE is freed.
+ */
+EDGEFILE *newEDGEFILEstream(int fd) {
+    assert(fd >= 0);
+    EDGEFILE *f = newStream(fd);
+    long n = 0;
+    while (n < DECOMPRESS_MAGIC) {
+        ssize_t r = read(fd, f->data + n, DECOMPRESS_MAGIC - n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) {
+            fprintf(stderr, "READ ERROR: %s\n", strerror(errno));
+            exit(1);
+        }
+        if (r == 0) break;
+        n += r;
+    }
+    int format = formatDECOMPRESSOR(f->data, n);
+    if (format != DECOMPRESS_NONE) {
+        memcpy(f->head, f->data, n);
+        decompress(f, format, f->head, n, fd);
+        return f;
+    }
+    // Otherwise they are plain bytes, with the end placed as refill would
+    f->filled = f->data + n;
+    f->size = n;
+    char *semi = f->filled - 1;
+    while (semi >= f->data && *semi != ';') semi--;
+    f->end = semi + 1;
+    return f;
+}
+
+
+/*
+ *  Method: readEDGEFILE
+ *  Usage:  while (readEDGEFILE(f, &u, &v, &weight)) ...
+ *  Description: This method reads the next record, returning false at the
+ *  end of the file. A missing weight defaults to 1, and the final record
+ *  may end at the end of the file instead of a semicolon. A malformed
+ *  record is reported on stderr with its line, column and byte offset, and
+ *  the program exits, as with readInt, unless skipEDGEFILE says otherwise.
+ */
+int readEDGEFILE(EDGEFILE *f, int *u, int *v, int *weight) {
+    assert(f != 0);
+    int r = scanRecord(f, u, v, weight);
+    if (r < 0) scanError(f, f->expected);
+    return r;
+}
+
+
+/*
+ *  Method: readEDGEFILEbatch
+ *  Usage:  int n = readEDGEFILEbatch(f, batch, 1024);
+ *  Description: This method reads up to max records into batch and returns
+ *  how many it read, which is zero only at the end of the file. Records and
+ *  errors are exactly as with readEDGEFILE.
+ */
+int readEDGEFILEbatch(EDGEFILE *f, EDGETRIPLE *batch, int max) {
+    assert(f != 0);
+    int count = scanBatch(f, batch, max);
+    if (f->expected) scanError(f, f->expected);
+    return count;
+}
+
+
+/*
+ *  Method: readEDGEFILEparallel
+ *  Usage:  EDGETRIPLE *all = readEDGEFILEparallel(f, 8, &count);
+ *  Description: This method reads every remaining record using the given
+ *  number of threads, and returns them in file order in a malloc'd array
+ *  whose length is stored in count. The bytes are split into even ranges,
+ *  each moved forward to just past a semicolon so that it starts on a
+ *  record, and each range is parsed on its own thread. A stream's bytes
+ *  only exist once they are read, so a stream is read on the calling
+ *  thread alone. Records and errors are exactly as with readEDGEFILE; if
+ *  several ranges are malformed, the first one in the file is reported.
+ */
+EDGETRIPLE *readEDGEFILEparallel(EDGEFILE *f, int threads, long *count) {
+    assert(f != 0);
+    assert(count != 0);
+    if (f->stream) {
+        CHUNK whole = { f, NULL, 0, 0 };
+        parseChunk(&whole);
+        if (f->expected) scanError(f, f->expected);
+        *count = whole.count;
+        return whole.edges;
+    }
+    if (threads < 1) threads = 1;
+    CHUNK *chunks = malloc(sizeof(CHUNK) * threads);
+    pthread_t *ids = malloc(sizeof(pthread_t) * threads);
+    char *started = malloc(threads);
+    assert(chunks != 0 && ids != 0 && started != 0);
+    long length = f->end - f->next;
+    char *from = f->next;
+    for (int i = 0; i < threads; i++) {
+        char *to = i == threads - 1 ? f->end : f->next + length / threads * (i + 1);
+        if (to < from) to = from;
+        if (to < f->end) {
+            char *semi = memchr(to, ';', f->end - to);
+            to = semi ? semi + 1 : f->end;
+        }
+        EDGEFILE *view = malloc(sizeof(EDGEFILE));
+        assert(view != 0);
+        *view = *f;
+        view->next = from;
+        view->end = to;
+        view->expected = NULL;
+        view->defer = 1;
+        view->deferred = NULL;
+        view->deferredCount = 0;
+        view->deferredCapacity = 0;
+        chunks[i].view = view;
+        chunks[i].edges = NULL;
+        chunks[i].count = 0;
+        chunks[i].capacity = 0;
+        from = to;
+    }
+    // The calling thread takes the first range itself
+    for (int i = 1; i < threads; i++) {
+        started[i] = pthread_create(&ids[i], NULL, parseChunk, &chunks[i]) == 0;
+        if (!started[i]) parseChunk(&chunks[i]);
+    }
+    parseChunk(&chunks[0]);
+    for (int i = 1; i < threads; i++) {
+        if (started[i]) pthread_join(ids[i], NULL);
+    }
+    // Each view started from f's count of skipped records
+    long before = f->skipped;
+    for (int i = 0; i < threads; i++) {
+        EDGEFILE *view = chunks[i].view;
+        for (long j = 0; j < view->deferredCount; j++) {
+            logSkipped(f, view->deferred[j].offset, view->deferred[j].expected);
+        }
+        f->skipped += view->skipped - before;
+        free(view->deferred);
+        if (view->expected) {
+            f->next = view->next;
+            scanError(f, view->expected);
+        }
+    }
+    // Concatenate in file order, growing the first buffer in place
+    long total = 0;
+    for (int i = 0; i < threads; i++) total += chunks[i].count;
+    EDGETRIPLE *all = realloc(chunks[0].edges, sizeof(EDGETRIPLE) * (total > 0 ? total : 1));
+    assert(all != 0);
+    long at = chunks[0].count;
+    free(chunks[0].view);
+    for (int i = 1; i < threads; i++) {
+        memcpy(all + at, chunks[i].edges, sizeof(EDGETRIPLE) * chunks[i].count);
+        at += chunks[i].count;
+        free(chunks[i].edges);
+        free(chunks[i].view);
+    }
+    free(chunks);
+    free(ids);
+    free(started);
+    f->next = f->end;
+    *count = total;
+    return all;
+}
+
+
+/*
+ *  Method: simdEDGEFILE
+ *  Usage:  int level = simdEDGEFILE(f, EDGEFILE_SCALAR);
+ *  Description: This method limits batches to the given code path, or the
+ *  best one the processor supports if that is lower, and returns the code
+ *  path now in use. The best supported path is chosen by default.
+ */
+int simdEDGEFILE(EDGEFILE *f, int level) {
+    assert(f != 0);
+    int best = bestLevel();
+    f->simd = level < best ? level : best;
+    return f->simd;
+}
+
+
+/*
+ *  Method: skipEDGEFILE
+ *  Usage:  skipEDGEFILE(f, EDGEFILE_SKIP);
+ *  Description: This method sets what happens to a malformed record. By
+ *  default it ends the program; EDGEFILE_SKIP logs it on stderr and goes
+ *  on from the next semicolon, and EDGEFILE_SKIP_QUIETLY only skips it.
+ */
+void skipEDGEFILE(EDGEFILE *f, int policy) {
+    assert(f != 0);
+    f->policy = policy;
+}
+
+
+/*
+ *  Method: skippedEDGEFILE
+ *  Usage:  long bad = skippedEDGEFILE(f);
+ *  Description: This method returns the number of malformed records
+ *  skipped since the file was opened or last rewound.
+ */
+long skippedEDGEFILE(EDGEFILE *f) {
+    assert(f != 0);
+    return f->skipped;
+}
+
+
+/*
+ *  Method: rewindEDGEFILE
+ *  Usage:  rewindEDGEFILE(f);
+ *  Description: This method moves back to the first record. A stream
+ *  cannot be rewound.
+ */
+void rewindEDGEFILE(EDGEFILE *f) {
+    assert(f != 0);
+    assert(!f->stream);
+    f->next = f->data;
+    f->counted = f->lines = f->lineStart = 0;
+    f->skipped = 0;
+}
+
+
+/*
+ *  Method: streamingEDGEFILE
+ *  Usage:  if (!streamingEDGEFILE(f)) rewindEDGEFILE(f);
+ *  Description: This method returns true if f is read as a stream.
+ */
+int streamingEDGEFILE(EDGEFILE *f) {
+    assert(f != 0);
+    return f->stream;
+}
+
+
+/*
+ *  Method: sizeEDGEFILE
+ *  Usage:  long bytes = sizeEDGEFILE(f);
+ *  Description: This method returns the size of the file in bytes, or for
+ *  a stream the number of bytes read so far.
+ */
+long sizeEDGEFILE(EDGEFILE *f) {
+    assert(f != 0);
+    return f->size;
+}
+
+
+/*
+ *  Method: freeEDGEFILE
+ *  Usage:  freeEDGEFILE(f);
+ *  Description: This method unmaps the file or frees the stream buffer,
+ *  closes a file it opened itself, and frees the EDGEFILE object.
+ */
+void freeEDGEFILE(EDGEFILE *f) {
+    assert(f != 0);
+    if (f->mapped) munmap(f->data, f->size);
+    else free(f->data);
+    if (f->inflater) freeDECOMPRESSOR(f->inflater);
+    if (f->source) munmap(f->source, f->sourceSize);
+    if (f->closeFd) close(f->input);
+    free(f);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   newBlank
+ *  Usage:  EDGEFILE *f = newBlank();
+ *  Description: This private method allocates an EDGEFILE with no bytes,
+ *  which the constructors then fill in.
+ */
+EDGEFILE *newBlank(void) {
+    EDGEFILE *f = malloc(sizeof(EDGEFILE));
+    assert(f != 0);
+    f->data = f->next = f->end = f->filled = NULL;
+    f->size = 0;
+    f->capacity = 0;
+    f->mapped = 0;
+    f->stream = 0;
+    f->ended = 0;
+    f->fd = -1;
+    f->input = -1;
+    f->closeFd = 0;
+    f->inflater = NULL;
+    f->source = NULL;
+    f->sourceSize = 0;
+    f->simd = bestLevel();
+    f->expected = NULL;
+    f->consumed = 0;
+    f->counted = 0;
+    f->lines = 0;
+    f->lineStart = 0;
+    f->policy = EDGEFILE_STOP;
+    f->skipped = 0;
+    f->defer = 0;
+    f->deferred = NULL;
+    f->deferredCount = 0;
+    f->deferredCapacity = 0;
+    return f;
+}
+
+
+/*
+ *  Method (private):   newStream
+ *  Usage:  EDGEFILE *f = newStream(fd);
+ *  Description: This private method allocates an EDGEFILE that streams fd
+ *  through an empty buffer.
+ */
+EDGEFILE *newStream(int fd) {
+    EDGEFILE *f = newBlank();
+    f->stream = 1;
+    f->fd = f->input = fd;
+    f->capacity = STREAM_BUFFER;
+    f->data = malloc(f->capacity);
+    assert(f->data != 0);
+    f->next = f->end = f->filled = f->data;
+    return f;
+}
+
+
+/*
+ *  Method (private):   decompress
+ *  Usage:  decompress(f, DECOMPRESS_GZIP, bytes, size, fd);
+ *  Description: This private method starts a decompressor on the given
+ *  bytes followed by fd, and makes the stream read its output.
+ */
+void decompress(EDGEFILE *f, int format, char *input, long size, int fd) {
+    f->inflater = newDECOMPRESSOR(format, input, size, fd);
+    f->fd = fdDECOMPRESSOR(f->inflater);
+}
+
+
+/*
+ *  Method (private):   refill
+ *  Usage:  if (refill(f)) ...
+ *  Description: This private method is called on a stream once the
+ *  tokenizer has reached f->end. It moves the partial record after the end
+ *  to the front of the buffer and reads until the buffer holds another
+ *  semicolon, doubling the buffer if a record does not fit. At the end of
+ *  the stream the partial record becomes the final one. It returns false
+ *  once there is nothing left to tokenize.
+ */
+int refill(EDGEFILE *f) {
+    if (!f->stream || f->ended) return 0;
+    // The bytes before next are about to go, so their lines are counted
+    countLines(f, f->next);
+    f->consumed += f->next - f->data;
+    long kept = f->filled - f->next;
+    memmove(f->data, f->next, kept);
+    f->next = f->end = f->data;
+    f->filled = f->data + kept;
+    while (1) {
+        if (f->filled - f->data == f->capacity) {
+            f->capacity *= 2;
+            char *p = realloc(f->data, f->capacity);
+            assert(p != 0);
+            f->filled = p + (f->filled - f->data);
+            f->data = f->next = f->end = p;
+        }
+        // Small reads keep the bytes countLines goes over still in cache
+        long room = f->capacity - (f->filled - f->data);
+        ssize_t n = read(f->fd, f->filled, room < STREAM_READ ? room : STREAM_READ);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            fprintf(stderr, "READ ERROR: %s\n", strerror(errno));
+            exit(1);
+        }
+        if (n == 0) {
+            // Nothing more is coming, so whatever is left is the final record
+            f->ended = 1;
+            f->end = f->filled;
+            return f->end > f->next;
+        }
+        char *fresh = f->filled;
+        f->filled += n;
+        f->size += n;
+        // Only the new bytes can hold a semicolon
+        char *semi = f->filled - 1;
+        while (semi >= fresh && *semi != ';') semi--;
+        if (semi >= fresh) {
+            f->end = semi + 1;
+            return 1;
+        }
+    }
+}
+
+
+/*
+ *  Method (private):   scanRecord
+ *  Usage:  int r = scanRecord(f, &u, &v, &weight);
+ *  Description: This private method reads the next record with the scalar
+ *  tokenizer. It returns 1 for a record and 0 at the end of the file; on a
+ *  malformed record it stores what was expected in f->expected, leaves
+ *  f->next on the offending character and returns -1, unless malformed
+ *  records are being skipped.
+ */
+int scanRecord(EDGEFILE *f, int *u, int *v, int *weight) {
+    int r;
+    while ((r = scanFields(f, u, v, weight)) < 0 && f->policy != EDGEFILE_STOP) {
+        skipRecord(f);
+    }
+    return r;
+}
+
+
+/*
+ *  Method (private):   scanFields
+ *  Usage:  int r = scanFields(f, &u, &v, &weight);
+ *  Description: This private method reads the fields of one record and
+ *  returns as scanRecord does when nothing is skipped.
+ */
+int scanFields(EDGEFILE *f, int *u, int *v, int *weight) {
+    skipSpace(f);
+    while (f->next == f->end && refill(f)) skipSpace(f);
+    if (f->next == f->end) return 0;
+    f->expected = "a vertex";
+    if (!scanInt(f, u)) return -1;
+    skipSpace(f);
+    if (!scanInt(f, v)) return -1;
+    skipSpace(f);
+    *weight = 1;
+    if (f->next < f->end && *f->next != ';') {
+        f->expected = "a weight or ';'";
+        if (!scanInt(f, weight)) return -1;
+        skipSpace(f);
+    }
+    if (f->next < f->end) {
+        f->expected = "';'";
+        if (*f->next != ';') return -1;
+        f->next++;
+    }
+    f->expected = NULL;
+    return 1;
+}
+
+
+/*
+ *  Method (private):   skipRecord
+ *  Usage:  skipRecord(f);
+ *  Description: This private method logs the malformed record at f->next,
+ *  or defers it in a parallel read, and moves past its semicolon. A
+ *  stream's end is always just past a semicolon or at the end of the
+ *  stream, so the rest of the record is already in the buffer.
+ */
+void skipRecord(EDGEFILE *f) {
+    long offset = offsetOf(f, f->next);
+    if (f->defer) {
+        if (f->deferredCount == f->deferredCapacity) {
+            f->deferredCapacity = f->deferredCapacity ? f->deferredCapacity * 2 : 16;
+            f->deferred = realloc(f->deferred, sizeof(BADRECORD) * f->deferredCapacity);
+            assert(f->deferred != 0);
+        }
+        f->deferred[f->deferredCount].offset = offset;
+        f->deferred[f->deferredCount].expected = f->expected;
+        f->deferredCount++;
+    }
+    else {
+        logSkipped(f, offset, f->expected);
+    }
+    f->skipped++;
+    f->expected = NULL;
+    char *semi = memchr(f->next, ';', f->end - f->next);
+    f->next = semi ? semi + 1 : f->end;
+}
+
+
+/*
+ *  Method (private):   logSkipped
+ *  Usage:  logSkipped(f, offset, "a vertex");
+ *  Description: This private method logs a skipped record on stderr,
+ *  unless records are being skipped quietly.
+ */
+void logSkipped(EDGEFILE *f, long offset, char *expected) {
+    if (f->policy != EDGEFILE_SKIP) return;
+    long line;
+    long column;
+    position(f, offset, &line, &column);
+    fprintf(stderr, "SKIPPED RECORD: expected %s at line %ld, column %ld (byte %ld)\n",
+            expected, line, column, offset);
+}
+
+
+/*
+ *  Method (private):   scanBatch
+ *  Usage:  int n = scanBatch(f, batch, max);
+ *  Description: This private method reads up to max records into batch,
+ *  stopping early at the end of the file or at a malformed record, which
+ *  is left in f->expected as with scanRecord.
+ */
+int scanBatch(EDGEFILE *f, EDGETRIPLE *batch, int max) {
+    int count = 0;
+    while (count < max) {
+#ifdef __x86_64__
+        while (f->simd != EDGEFILE_SCALAR && count + RECORDS <= max &&
+                f->end - f->next >= WINDOW + LONGEST) {
+            int used = 0;
+            int n = f->simd == EDGEFILE_AVX2
+                ? windowAVX2(f->next, batch + count, &used)
+                : windowSSE42(f->next, batch + count, &used);
+            if (n < 0) break;
+            count += n;
+            f->next += used;
+        }
+        if (count == max) break;
+#endif
+        // The scalar tokenizer takes records the windows cannot, and
+        // refills a stream when the windows have run out of bytes
+        EDGETRIPLE *e = &batch[count];
+        if (scanRecord(f, &e->u, &e->v, &e->weight) <= 0) break;
+        count++;
+    }
+    return count;
+}
+
+
+/*
+ *  Method (private):   parseChunk
+ *  Usage:  pthread_create(&id, NULL, parseChunk, &chunk);
+ *  Description: This private method is the body of a parallel read. It
+ *  parses the chunk's range into its own growing buffer, stopping at the
+ *  first malformed record.
+ */
+void *parseChunk(void *arg) {
+    CHUNK *c = arg;
+    EDGEFILE *view = c->view;
+    c->capacity = (view->end - view->next) / 16 + RECORDS;
+    c->edges = malloc(sizeof(EDGETRIPLE) * c->capacity);
+    assert(c->edges != 0);
+    while (1) {
+        if (c->capacity - c->count < RECORDS) {
+            c->capacity *= 2;
+            c->edges = realloc(c->edges, sizeof(EDGETRIPLE) * c->capacity);
+            assert(c->edges != 0);
+        }
+        int room = c->capacity - c->count < INT_MAX ? c->capacity - c->count : INT_MAX;
+        int n = scanBatch(view, c->edges + c->count, room);
+        c->count += n;
+        if (n == 0 || view->expected) break;
+    }
+    return NULL;
+}
+
+
+/*
+ *  Method (private):   isSpace
+ *  Usage:  if (isSpace(c)) ...
+ *  Description: This private method matches the whitespace that fscanf
+ *  skips in the C locale.
+ */
+int isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+
+void skipSpace(EDGEFILE *f) {
+    while (f->next < f->end && isSpace(*f->next)) f->next++;
+}
+
+
+/*
+ *  Method (private):   scanInt
+ *  Usage:  int ok = scanInt(f, &x);
+ *  Description: This private method reads an optionally signed decimal
+ *  integer at the current position, returning false if there is none.
+ */
+int scanInt(EDGEFILE *f, int *x) {
+    char *p = f->next;
+    int negative = 0;
+    if (p < f->end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == f->end || *p < '0' || *p > '9') return 0;
+    unsigned int value = 0;
+    while (p < f->end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    *x = negative ? (int) -value : (int) value;
+    f->next = p;
+    return 1;
+}
+
+
+/*
+ *  Method (private):   scanError
+ *  Usage:  scanError(f, "a vertex");
+ *  Description: This private method reports what was expected, where, and
+ *  the offending character, then exits.
+ */
+void scanError(EDGEFILE *f, char *expected) {
+    long offset = offsetOf(f, f->next);
+    long line;
+    long column;
+    position(f, offset, &line, &column);
+    fprintf(stderr, "SCAN ERROR: expected %s at line %ld, column %ld (byte %ld)\n",
+            expected, line, column, offset);
+    if (f->next < f->end) {
+        fprintf(stderr, "offending character was <%c>\n", *f->next);
+    }
+    else {
+        fprintf(stderr, "reached the end of the file\n");
+    }
+    exit(1);
+}
+
+
+/*
+ *  Method (private):   offsetOf
+ *  Usage:  long offset = offsetOf(f, f->next);
+ *  Description: This private method returns the byte offset in the input
+ *  of a position in the buffer. Compressed input is counted after it is
+ *  decompressed.
+ */
+long offsetOf(EDGEFILE *f, char *p) {
+    return f->consumed + (p - f->data);
+}
+
+
+/*
+ *  Method (private):   position
+ *  Usage:  position(f, offset, &line, &column);
+ *  Description: This private method finds the line and column, both
+ *  counted from 1, of a byte offset at or after the last one counted.
+ */
+void position(EDGEFILE *f, long offset, long *line, long *column) {
+    assert(offset >= f->counted);
+    countLines(f, f->data + (offset - f->consumed));
+    *line = f->lines + 1;
+    *column = offset - f->lineStart + 1;
+}
+
+
+/*
+ *  Method (private):   countLines
+ *  Usage:  countLines(f, f->next);
+ *  Description: This private method counts the newlines from the last
+ *  position counted up to a position in the buffer. On x86-64 it compares
+ *  sixteen bytes at a time, which SSE2 always allows, adding up the
+ *  matches in byte counters that are folded into the total before they
+ *  can overflow.
+ */
+void countLines(EDGEFILE *f, char *to) {
+    char *p = f->data + (f->counted - f->consumed);
+    if (to <= p) return;
+    long newlines = 0;
+    char *q = p;
+#ifdef __x86_64__
+    __m128i newline = _mm_set1_epi8('\n');
+    while (to - q >= 16) {
+        __m128i counts = _mm_setzero_si128();
+        for (int i = 0; i < 255 && to - q >= 16; i++, q += 16) {
+            __m128i bytes = _mm_loadu_si128((__m128i *) q);
+            counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(bytes, newline));
+        }
+        __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        newlines += _mm_cvtsi128_si64(sums) + _mm_extract_epi16(sums, 4);
+    }
+#endif
+    for (; q < to; q++) newlines += *q == '\n';
+    if (newlines > 0) {
+        char *last = to - 1;
+        while (*last != '\n') last--;
+        f->lineStart = offsetOf(f, last + 1);
+        f->lines += newlines;
+    }
+    f->counted = offsetOf(f, to);
+}
+
+
+/*
+ *  Method (private):   bestLevel
+ *  Usage:  int level = bestLevel();
+ *  Description: This private method returns the best tokenizer code path
+ *  the processor supports.
+ */
+int bestLevel(void) {
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("avx2")) return EDGEFILE_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return EDGEFILE_SSE42;
+#endif
+    return EDGEFILE_SCALAR;
+}
+
+
+/*
+ *  Method (private):   locate
+ *  Usage:  int records = locate(p, &masks, &tokens, &used);
+ *  Description: This private method finds the tokens of every complete
+ *  record in a classified window, and stores in used the bytes up to and
+ *  including the last semicolon. Tokens start and stop where the digit
+ *  mask turns on and off, and each semicolon closes a record holding the
+ *  tokens started since the one before. It returns the number of records,
+ *  or -1 if the window needs the scalar tokenizer. It is inlined into each
+ *  window method so that it is compiled for the same processor.
+ */
+static inline __attribute__((always_inline))
+int locate(char *p, MASKS *m, TOKENLIST *t, int *used) {
+    int last = -1;
+    for (int w = WORDS - 1; w >= 0 && last < 0; w--) {
+        if (m->semi[w]) last = w * 64 + 63 - __builtin_clzll(m->semi[w]);
+    }
+    if (last < 0) return -1;
+    int records = 0;
+    int starts = 0;
+    int stops = 0;
+    int previous = 0;
+    uint64_t digitCarry = 0;
+    uint64_t signCarry = 0;
+    for (int w = 0; w <= last / 64; w++) {
+        uint64_t limit = w < last / 64 ? ~0ULL : ~0ULL >> (63 - last % 64);
+        uint64_t known = m->digit[w] | m->sign[w] | m->semi[w] | m->space[w];
+        if (~known & limit) return -1;
+        uint64_t digit = m->digit[w] & limit;
+        uint64_t sign = m->sign[w] & limit;
+        uint64_t semi = m->semi[w] & limit;
+        uint64_t nextDigit = w < last / 64 ? m->digit[w + 1] & 1 : 0;
+        uint64_t digitBefore = digit << 1 | digitCarry;
+        uint64_t digitAfter = digit >> 1 | nextDigit << 63;
+        // a sign must be followed by a digit and not follow one
+        if (sign & (~digitAfter | digitBefore)) return -1;
+        uint64_t first = digit & ~digitBefore;
+        uint64_t final = digit & ~digitAfter;
+        uint64_t signed_ = (sign << 1 | signCarry) & first;
+        digitCarry = digit >> 63;
+        signCarry = sign >> 63;
+        while (semi) {
+            int b = __builtin_ctzll(semi);
+            semi &= semi - 1;
+            int before = starts + __builtin_popcountll(first & ((1ULL << b) - 1));
+            int fields = before - previous;
+            if (fields < 2 || fields > 3) return -1;
+            t->fields[records++] = fields;
+            previous = before;
+        }
+        while (first) {
+            int pos = w * 64 + __builtin_ctzll(first);
+            first &= first - 1;
+            t->start[starts] = pos;
+            t->negative[starts] = (signed_ >> (pos % 64) & 1) && p[pos - 1] == '-';
+            starts++;
+        }
+        while (final) {
+            int pos = w * 64 + __builtin_ctzll(final);
+            final &= final - 1;
+            int length = pos - t->start[stops] + 1;
+            if (length > LONGEST) return -1;
+            t->length[stops++] = length;
+        }
+    }
+    t->count = starts;
+    *used = last + 1;
+    return records;
+}
+
+
+/*
+ *  Method (private):   assemble
+ *  Usage:  assemble(&tokens, records, out);
+ *  Description: This private method turns converted tokens into triples.
+ */
+void assemble(TOKENLIST *t, int records, EDGETRIPLE *out) {
+    int k = 0;
+    for (int r = 0; r < records; r++) {
+        out[r].u = t->value[k];
+        out[r].v = t->value[k + 1];
+        out[r].weight = t->fields[r] == 3 ? t->value[k + 2] : 1;
+        k += t->fields[r];
+    }
+}
+
+
+#ifdef __x86_64__
+
+/* shuffle controls that right-align the first n bytes, loaded at offset n */
+static const char alignTable[32] = {
+    -128, -128, -128, -128, -128, -128, -128, -128,
+    -128, -128, -128, -128, -128, -128, -128, -128,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+
+/*
+ *  Method (private):   convertSSE42
+ *  Usage:  int x = convertSSE42(digits, length, negative);
+ *  Description: This private method converts up to 16 digits at once. The
+ *  digits are right-aligned in a vector and combined pairwise, into two,
+ *  four and then eight digit groups, by multiply-adds. Like scanInt, the
+ *  result wraps around instead of overflowing.
+ */
+__attribute__((target("sse4.2")))
+static inline int convertSSE42(char *digits, int length, int negative) {
+    __m128i x = _mm_loadu_si128((__m128i *) digits);
+    x = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    x = _mm_shuffle_epi8(x, _mm_loadu_si128((__m128i *) (alignTable + length)));
+    x = _mm_maddubs_epi16(x, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                           10, 1, 10, 1, 10, 1, 10, 1));
+    x = _mm_madd_epi16(x, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    x = _mm_packus_epi32(x, x);
+    x = _mm_madd_epi16(x, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    uint64_t high = (uint32_t) _mm_cvtsi128_si32(x);
+    uint64_t low = (uint32_t) _mm_extract_epi32(x, 1);
+    unsigned int value = high * 100000000 + low;
+    return negative ? (int) -value : (int) value;
+}
+
+
+/*
+ *  Method (private):   windowSSE42
+ *  Usage:  int n = windowSSE42(p, out, &used);
+ *  Description: This private method parses a window sixteen bytes at a
+ *  time and converts one token per multiply-add chain.
+ */
+__attribute__((target("sse4.2")))
+int windowSSE42(char *p, EDGETRIPLE *out, int *used) {
+    MASKS m;
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8('\r' - '\t');
+    for (int w = 0; w < WORDS; w++) {
+        uint64_t digit = 0, sign = 0, semi = 0, space = 0;
+        for (int i = 0; i < 4; i++) {
+            __m128i x = _mm_loadu_si128((__m128i *) (p + w * 64 + i * 16));
+            __m128i d = _mm_sub_epi8(x, zero);
+            __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+            __m128i c = _mm_sub_epi8(x, tab);
+            __m128i isSpace = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(c, four), c),
+                                           _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+            __m128i isSign = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('-')),
+                                          _mm_cmpeq_epi8(x, _mm_set1_epi8('+')));
+            __m128i isSemi = _mm_cmpeq_epi8(x, _mm_set1_epi8(';'));
+            digit |= (uint64_t) (uint16_t) _mm_movemask_epi8(isDigit) << (i * 16);
+            space |= (uint64_t) (uint16_t) _mm_movemask_epi8(isSpace) << (i * 16);
+            sign |= (uint64_t) (uint16_t) _mm_movemask_epi8(isSign) << (i * 16);
+            semi |= (uint64_t) (uint16_t) _mm_movemask_epi8(isSemi) << (i * 16);
+        }
+        m.digit[w] = digit;
+        m.sign[w] = sign;
+        m.semi[w] = semi;
+        m.space[w] = space;
+    }
+    TOKENLIST t;
+    int records = locate(p, &m, &t, used);
+    if (records < 0) return -1;
+    for (int i = 0; i < t.count; i++) {
+        t.value[i] = convertSSE42(p + t.start[i], t.length[i], t.negative[i]);
+    }
+    assemble(&t, records, out);
+    return records;
+}
+
+
+/*
+ *  Method (private):   windowAVX2
+ *  Usage:  int n = windowAVX2(p, out, &used);
+ *  Description: This private method parses a window thirty-two bytes at a
+ *  time and converts two tokens per multiply-add chain, one in each half
+ *  of the vector.
+ */
+__attribute__((target("avx2")))
+int windowAVX2(char *p, EDGETRIPLE *out, int *used) {
+    MASKS m;
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8('\r' - '\t');
+    for (int w = 0; w < WORDS; w++) {
+        uint64_t digit = 0, sign = 0, semi = 0, space = 0;
+        for (int i = 0; i < 2; i++) {
+            __m256i x = _mm256_loadu_si256((__m256i *) (p + w * 64 + i * 32));
+            __m256i d = _mm256_sub_epi8(x, zero);
+            __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d);
+            __m256i c = _mm256_sub_epi8(x, tab);
+            __m256i isSpace = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(c, four), c),
+                                              _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+            __m256i isSign = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('-')),
+                                             _mm256_cmpeq_epi8(x, _mm256_set1_epi8('+')));
+            __m256i isSemi = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(';'));
+            digit |= (uint64_t) (uint32_t) _mm256_movemask_epi8(isDigit) << (i * 32);
+            space |= (uint64_t) (uint32_t) _mm256_movemask_epi8(isSpace) << (i * 32);
+            sign |= (uint64_t) (uint32_t) _mm256_movemask_epi8(isSign) << (i * 32);
+            semi |= (uint64_t) (uint32_t) _mm256_movemask_epi8(isSemi) << (i * 32);
+        }
+        m.digit[w] = digit;
+        m.sign[w] = sign;
+        m.semi[w] = semi;
+        m.space[w] = space;
+    }
+    TOKENLIST t;
+    int records = locate(p, &m, &t, used);
+    if (records < 0) return -1;
+    const __m256i pairs = _mm256_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1,
+                                           10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+    const __m256i quads = _mm256_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1,
+                                            100, 1, 100, 1, 100, 1, 100, 1);
+    const __m256i octets = _mm256_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1,
+                                             10000, 1, 10000, 1, 10000, 1, 10000, 1);
+    int i = 0;
+    for (; i + 1 < t.count; i += 2) {
+        __m128i a = _mm_loadu_si128((__m128i *) (p + t.start[i]));
+        __m128i b = _mm_loadu_si128((__m128i *) (p + t.start[i + 1]));
+        __m128i sa = _mm_loadu_si128((__m128i *) (alignTable + t.length[i]));
+        __m128i sb = _mm_loadu_si128((__m128i *) (alignTable + t.length[i + 1]));
+        __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+        __m256i s = _mm256_inserti128_si256(_mm256_castsi128_si256(sa), sb, 1);
+        x = _mm256_shuffle_epi8(_mm256_sub_epi8(x, zero), s);
+        x = _mm256_maddubs_epi16(x, pairs);
+        x = _mm256_madd_epi16(x, quads);
+        x = _mm256_packus_epi32(x, x);
+        x = _mm256_madd_epi16(x, octets);
+        uint64_t highA = (uint32_t) _mm256_extract_epi32(x, 0);
+        uint64_t lowA = (uint32_t) _mm256_extract_epi32(x, 1);
+        uint64_t highB = (uint32_t) _mm256_extract_epi32(x, 4);
+        uint64_t lowB = (uint32_t) _mm256_extract_epi32(x, 5);
+        unsigned int va = highA * 100000000 + lowA;
+        unsigned int vb = highB * 100000000 + lowB;
+        t.value[i] = t.negative[i] ? (int) -va : (int) va;
+        t.value[i + 1] = t.negative[i + 1] ? (int) -vb : (int) vb;
+    }
+    if (i < t.count) {
+        t.value[i] = convertSSE42(p + t.start[i], t.length[i], t.negative[i]);
+    }
+    assemble(&t, records, out);
+    return records;
+}
+
+#endif
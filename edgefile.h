@@ -0,0 +1,49 @@
+/*
+ *  File:   edgefile.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the edgefile module, a
+ *  reader for edge files of the form "u v [weight] ;". A regular file is
+ *  mapped into memory, a pipe or stdin ("-") is streamed through a buffer,
+ *  and either is tokenized by hand instead of going through fscanf. gzip
+ *  and zstd input is recognized and decompressed on the fly.
+ *  Records can be read one at a time, in batches, or all at once across
+ *  several threads; batches use SSE4.2 or AVX2 when the processor has them.
+ *  Malformed records are reported by line, column and byte offset, and can
+ *  be skipped instead of ending the program.
+ */
+
+#ifndef __EDGEFILE_INCLUDED__
+#define __EDGEFILE_INCLUDED__
+
+/* tokenizer code paths, in order of preference */
+#define EDGEFILE_SCALAR 0
+#define EDGEFILE_SSE42 1
+#define EDGEFILE_AVX2 2
+
+/* what happens to a malformed record */
+#define EDGEFILE_STOP 0             /* report it and exit (the default) */
+#define EDGEFILE_SKIP 1             /* log it on stderr and go on */
+#define EDGEFILE_SKIP_QUIETLY 2     /* go on without a word */
+
+typedef struct edgetriple {
+    int u;
+    int v;
+    int weight;
+} EDGETRIPLE;
+
+typedef struct EDGEFILE EDGEFILE;
+
+extern EDGEFILE *newEDGEFILE(char *filename);
+extern EDGEFILE *newEDGEFILEstream(int fd);
+extern int readEDGEFILE(EDGEFILE *f, int *u, int *v, int *weight);
+extern int readEDGEFILEbatch(EDGEFILE *f, EDGETRIPLE *batch, int max);
+extern EDGETRIPLE *readEDGEFILEparallel(EDGEFILE *f, int threads, long *count);
+extern int simdEDGEFILE(EDGEFILE *f, int level);
+extern void skipEDGEFILE(EDGEFILE *f, int policy);
+extern long skippedEDGEFILE(EDGEFILE *f);
+extern void rewindEDGEFILE(EDGEFILE *f);
+extern int streamingEDGEFILE(EDGEFILE *f);
+extern long sizeEDGEFILE(EDGEFILE *f);
+extern void freeEDGEFILE(EDGEFILE *f);
+
+#endif // !__EDGEFILE_INCLUDED__
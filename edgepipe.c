@@ -0,0 +1,274 @@
+/*
+ *  File:   edgepipe.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the edgepipe module.
+ *  The reader thread reads the file as an edgefile stream, which uses
+ *  read() alone and hands the tokenizer whole records only. Batches travel
+ *  through a ring of slots guarded by one mutex: the reader waits when
+ *  every slot is full and the builder waits when every slot is empty, and
+ *  each side adds up how long it waited.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "edgepipe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define BATCH 16384         /* records per slot */
+
+
+// EDGEPIPE private method prototypes
+static void *readBatches(void *arg);
+static EDGETRIPLE *waitEmpty(EDGEPIPE *p);
+static int publish(EDGEPIPE *p, int count);
+static double now(void);
+
+
+/*
+ *  Type:   EDGEPIPE
+ *  Description: This is the struct definition for the EDGEPIPE class. The
+ *  used slots starting at head hold batches for the builder, which keeps
+ *  the head slot until it asks for the next batch.
+ */
+struct EDGEPIPE {
+    int fd;
+    EDGEFILE *file;
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;
+    pthread_cond_t emptied;
+    EDGETRIPLE **slots;
+    int *counts;
+    int capacity;
+    int head;
+    int used;
+    int holding;
+    int done;
+    int cancelled;
+    double readerStall;
+    double builderStall;
+    long skipped;
+};
+
+
+/*
+ *  Constructor: newEDGEPIPE
+ *  Usage:  EDGEPIPE *p = newEDGEPIPE("graph.data", 4, EDGEFILE_STOP);
+ *  Description: This is the constructor used to instantiate a new EDGEPIPE
+ *  object with the given number of queue slots, reading stdin if filename
+ *  is "-", and treating malformed records by the given skipEDGEFILE
+ *  policy. It starts the reader thread, and returns NULL if the file
+ *  cannot be opened or the thread cannot be started.
+ */
+EDGEPIPE *newEDGEPIPE(char *filename, int slots, int policy) {
+    assert(slots > 0);
+    int fd = strcmp(filename, "-") == 0 ? STDIN_FILENO : open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    EDGEPIPE *p = malloc(sizeof(EDGEPIPE));
+    assert(p != 0);
+    p->fd = fd;
+    p->file = newEDGEFILEstream(fd);
+    skipEDGEFILE(p->file, policy);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->filled, NULL);
+    pthread_cond_init(&p->emptied, NULL);
+    p->slots = malloc(sizeof(EDGETRIPLE *) * slots);
+    p->counts = malloc(sizeof(int) * slots);
+    assert(p->slots != 0 && p->counts != 0);
+    for (int i = 0; i < slots; i++) {
+        p->slots[i] = malloc(sizeof(EDGETRIPLE) * BATCH);
+        assert(p->slots[i] != 0);
+    }
+    p->capacity = slots;
+    p->head = 0;
+    p->used = 0;
+    p->holding = 0;
+    p->done = 0;
+    p->cancelled = 0;
+    p->readerStall = 0;
+    p->builderStall = 0;
+    p->skipped = 0;
+    if (pthread_create(&p->reader, NULL, readBatches, p) != 0) {
+        // Nothing else has been started, so just undo the allocations
+        for (int i = 0; i < slots; i++) free(p->slots[i]);
+        free(p->slots);
+        free(p->counts);
+        freeEDGEFILE(p->file);
+        if (fd != STDIN_FILENO) close(fd);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+
+/*
+ *  Method: nextEDGEPIPE
+ *  Usage:  while ((n = nextEDGEPIPE(p, &batch)) > 0) ...
+ *  Description: This method hands back the previous batch and waits for
+ *  the next one, returning how many records it holds, or zero at the end
+ *  of the file. The batch stays valid until the next call. Records and
+ *  errors are exactly as with readEDGEFILE.
+ */
+int nextEDGEPIPE(EDGEPIPE *p, EDGETRIPLE **batch) {
+    assert(p != 0);
+    assert(batch != 0);
+    pthread_mutex_lock(&p->lock);
+    if (p->holding) {
+        p->head = (p->head + 1) % p->capacity;
+        p->used--;
+        p->holding = 0;
+        pthread_cond_signal(&p->emptied);
+    }
+    if (p->used == 0 && !p->done) {
+        double start = now();
+        while (p->used == 0 && !p->done) pthread_cond_wait(&p->filled, &p->lock);
+        p->builderStall += now() - start;
+    }
+    int count = 0;
+    if (p->used > 0) {
+        *batch = p->slots[p->head];
+        count = p->counts[p->head];
+        p->holding = 1;
+    }
+    pthread_mutex_unlock(&p->lock);
+    return count;
+}
+
+
+/*
+ *  Method: stallEDGEPIPE
+ *  Usage:  stallEDGEPIPE(p, &reader, &builder);
+ *  Description: This method stores the seconds the reader has spent
+ *  waiting for a free slot and the builder has spent waiting for a batch.
+ */
+void stallEDGEPIPE(EDGEPIPE *p, double *reader, double *builder) {
+    assert(p != 0);
+    pthread_mutex_lock(&p->lock);
+    *reader = p->readerStall;
+    *builder = p->builderStall;
+    pthread_mutex_unlock(&p->lock);
+}
+
+
+/*
+ *  Method: skippedEDGEPIPE
+ *  Usage:  long bad = skippedEDGEPIPE(p);
+ *  Description: This method returns the number of malformed records the
+ *  reader skipped, which is only complete once nextEDGEPIPE has returned
+ *  zero.
+ */
+long skippedEDGEPIPE(EDGEPIPE *p) {
+    assert(p != 0);
+    pthread_mutex_lock(&p->lock);
+    long skipped = p->skipped;
+    pthread_mutex_unlock(&p->lock);
+    return skipped;
+}
+
+
+/*
+ *  Method: freeEDGEPIPE
+ *  Usage:  freeEDGEPIPE(p);
+ *  Description: This method stops the reader thread, if it is still
+ *  running, closes the file unless it is stdin, and frees the EDGEPIPE
+ *  object.
+ */
+void freeEDGEPIPE(EDGEPIPE *p) {
+    assert(p != 0);
+    pthread_mutex_lock(&p->lock);
+    p->cancelled = 1;
+    pthread_cond_signal(&p->emptied);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->reader, NULL);
+    for (int i = 0; i < p->capacity; i++) free(p->slots[i]);
+    free(p->slots);
+    free(p->counts);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->filled);
+    pthread_cond_destroy(&p->emptied);
+    freeEDGEFILE(p->file);
+    if (p->fd != STDIN_FILENO) close(p->fd);
+    free(p);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   readBatches
+ *  Usage:  pthread_create(&p->reader, NULL, readBatches, p);
+ *  Description: This private method is the body of the reader thread. It
+ *  tokenizes records into free slots and queues them for the builder
+ *  until the file ends or the pipeline is freed.
+ */
+void *readBatches(void *arg) {
+    EDGEPIPE *p = arg;
+    EDGETRIPLE *slot;
+    while ((slot = waitEmpty(p)) != NULL) {
+        int n = readEDGEFILEbatch(p->file, slot, BATCH);
+        if (n == 0 || !publish(p, n)) break;
+    }
+    pthread_mutex_lock(&p->lock);
+    p->skipped = skippedEDGEFILE(p->file);
+    p->done = 1;
+    pthread_cond_signal(&p->filled);
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+
+/*
+ *  Method (private):   waitEmpty
+ *  Usage:  EDGETRIPLE *slot = waitEmpty(p);
+ *  Description: This private method waits for a free slot and returns it,
+ *  or returns NULL if the pipeline is being freed.
+ */
+EDGETRIPLE *waitEmpty(EDGEPIPE *p) {
+    pthread_mutex_lock(&p->lock);
+    if (p->used == p->capacity && !p->cancelled) {
+        double start = now();
+        while (p->used == p->capacity && !p->cancelled) {
+            pthread_cond_wait(&p->emptied, &p->lock);
+        }
+        p->readerStall += now() - start;
+    }
+    EDGETRIPLE *slot = NULL;
+    if (!p->cancelled) slot = p->slots[(p->head + p->used) % p->capacity];
+    pthread_mutex_unlock(&p->lock);
+    return slot;
+}
+
+
+/*
+ *  Method (private):   publish
+ *  Usage:  int ok = publish(p, count);
+ *  Description: This private method queues the slot just filled, returning
+ *  false if the pipeline is being freed.
+ */
+int publish(EDGEPIPE *p, int count) {
+    pthread_mutex_lock(&p->lock);
+    int ok = !p->cancelled;
+    if (ok) {
+        p->counts[(p->head + p->used) % p->capacity] = count;
+        p->used++;
+        pthread_cond_signal(&p->filled);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return ok;
+}
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
@@ -0,0 +1,24 @@
+/*
+ *  File:   edgepipe.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the edgepipe module, a
+ *  two-stage pipeline for loading edge files. A reader thread reads the
+ *  file in large blocks and tokenizes them into batches of records, which
+ *  the caller takes one at a time through a bounded queue while the next
+ *  ones are being read.
+ */
+
+#ifndef __EDGEPIPE_INCLUDED__
+#define __EDGEPIPE_INCLUDED__
+
+#include "edgefile.h"
+
+typedef struct EDGEPIPE EDGEPIPE;
+
+extern EDGEPIPE *newEDGEPIPE(char *filename, int slots, int policy);
+extern int nextEDGEPIPE(EDGEPIPE *p, EDGETRIPLE **batch);
+extern void stallEDGEPIPE(EDGEPIPE *p, double *reader, double *builder);
+extern long skippedEDGEPIPE(EDGEPIPE *p);
+extern void freeEDGEPIPE(EDGEPIPE *p);
+
+#endif // !__EDGEPIPE_INCLUDED__
@@ -0,0 +1,252 @@
+/*
+ *  File:   edgeset.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the edgeset module. The
+ *  set is a power-of-two array of (key, weight) slots probed linearly from a
+ *  multiplicative hash of the packed edge key.
+ */
+
+#include "edgeset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define INITIAL_CAPACITY 1024
+#define EMPTY_KEY UINT64_MAX    /* packs the self-loop (-1,-1) */
+
+typedef struct slot {
+    uint64_t key;
+    int weight;
+} SLOT;
+
+
+// EDGESET private method prototypes
+static uint64_t packEdge(int u, int v);
+static SLOT *probe(EDGESET *s, uint64_t key);
+static void grow(EDGESET *s);
+static int keep(EDGESET *s, int *stored, int weight);
+static void noteProbe(EDGESET *s, SLOT *slot, uint64_t key);
+
+
+/*
+ *  Type:   EDGESET
+ *  Description: This is the struct definition for the EDGESET class. The only
+ *  key that cannot live in the table is the empty marker itself, so it is
+ *  tracked on the side.
+ */
+struct EDGESET {
+    SLOT *slots;
+    int capacity;
+    int shift;
+    int size;
+    int policy;
+    int hasEmptyKey;
+    int emptyKeyWeight;
+    int longest;
+};
+
+
+/*
+ *  Constructor: newEDGESET
+ *  Usage:  EDGESET *s = newEDGESET(EDGESET_FIRST);
+ *  Description: This is the constructor used to instantiate a new EDGESET
+ *  object. The policy decides which copy of a parallel edge is kept.
+ */
+EDGESET *newEDGESET(int policy) {
+    EDGESET *s = malloc(sizeof(EDGESET));
+    assert(s != 0);
+    s->capacity = INITIAL_CAPACITY;
+    s->shift = 64 - 10;
+    s->slots = malloc(sizeof(SLOT) * s->capacity);
+    assert(s->slots != 0);
+    for (int i = 0; i < s->capacity; i++) s->slots[i].key = EMPTY_KEY;
+    s->size = 0;
+    s->policy = policy;
+    s->hasEmptyKey = 0;
+    s->emptyKeyWeight = 0;
+    s->longest = 0;
+    return s;
+}
+
+
+/*
+ *  Method: insertEDGESET
+ *  Usage:  int result = insertEDGESET(s, u, v, weight);
+ *  Description: This method adds the undirected edge (u,v) to the set, doing
+ *  a single probe for both orientations. It returns EDGESET_ADDED for a new
+ *  edge, and otherwise EDGESET_LOWERED or EDGESET_DUPLICATE depending on
+ *  whether the policy replaced the stored weight. This method runs in
+ *  amortized constant time.
+ */
+int insertEDGESET(EDGESET *s, int u, int v, int weight) {
+    assert(s != 0);
+    uint64_t key = packEdge(u, v);
+    if (key == EMPTY_KEY) {
+        if (s->hasEmptyKey) return keep(s, &s->emptyKeyWeight, weight);
+        s->hasEmptyKey = 1;
+        s->emptyKeyWeight = weight;
+        s->size++;
+        return EDGESET_ADDED;
+    }
+    SLOT *slot = probe(s, key);
+    if (slot->key == key) return keep(s, &slot->weight, weight);
+    slot->key = key;
+    slot->weight = weight;
+    noteProbe(s, slot, key);
+    s->size++;
+    // Keep the load factor at or below 1/2
+    if (s->size * 2 > s->capacity) grow(s);
+    return EDGESET_ADDED;
+}
+
+
+/*
+ *  Method: findEDGESET
+ *  Usage:  int found = findEDGESET(s, u, v, &weight);
+ *  Description: This method returns true if the undirected edge (u,v) is in
+ *  the set. If so and weight is not NULL, the stored weight is written there.
+ */
+int findEDGESET(EDGESET *s, int u, int v, int *weight) {
+    assert(s != 0);
+    uint64_t key = packEdge(u, v);
+    if (key == EMPTY_KEY) {
+        if (s->hasEmptyKey && weight != NULL) *weight = s->emptyKeyWeight;
+        return s->hasEmptyKey;
+    }
+    SLOT *slot = probe(s, key);
+    if (slot->key != key) return 0;
+    if (weight != NULL) *weight = slot->weight;
+    return 1;
+}
+
+
+/*
+ *  Method: sizeEDGESET
+ *  Usage:  int n = sizeEDGESET(s);
+ *  Description: This method returns the number of distinct edges in the set.
+ */
+int sizeEDGESET(EDGESET *s) {
+    assert(s != 0);
+    return s->size;
+}
+
+
+/*
+ *  Method: statisticsEDGESET
+ *  Usage:  statisticsEDGESET(s, stdout);
+ *  Description: This method displays the number of edges in the set, the
+ *  number of slots in the table, and the longest probe sequence, which is
+ *  tracked as edges are placed. This method runs in constant time.
+ *  Example Output:
+ *                  Edges: 25
+ *                  Slots: 1024
+ *                  Longest probe: 2
+ */
+void statisticsEDGESET(EDGESET *s, FILE *fp) {
+    assert(s != 0);
+    fprintf(fp, "Edges: %d\n", s->size);
+    fprintf(fp, "Slots: %d\n", s->capacity);
+    fprintf(fp, "Longest probe: %d\n", s->longest);
+}
+
+
+/*
+ *  Method: freeEDGESET
+ *  Usage:  freeEDGESET(s);
+ *  Description: This method frees the slot table and the set itself.
+ */
+void freeEDGESET(EDGESET *s) {
+    assert(s != 0);
+    free(s->slots);
+    free(s);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   packEdge
+ *  Usage:  uint64_t key = packEdge(u, v);
+ *  Description: This private method packs an undirected edge into a single
+ *  integer with the smaller vertex in the high half, so that both
+ *  orientations of an edge share one key.
+ */
+uint64_t packEdge(int u, int v) {
+    if (u > v) {
+        int tmp = u;
+        u = v;
+        v = tmp;
+    }
+    return (uint64_t)(uint32_t) u << 32 | (uint32_t) v;
+}
+
+
+/*
+ *  Method (private):   probe
+ *  Usage:  SLOT *slot = probe(s, key);
+ *  Description: This private method returns the slot holding key, or the
+ *  empty slot where key belongs if it is not in the table.
+ */
+SLOT *probe(EDGESET *s, uint64_t key) {
+    int mask = s->capacity - 1;
+    int i = (key * 0x9E3779B97F4A7C15ULL) >> s->shift;
+    while (s->slots[i].key != key && s->slots[i].key != EMPTY_KEY) {
+        i = (i + 1) & mask;
+    }
+    return &s->slots[i];
+}
+
+
+/*
+ *  Method (private):   grow
+ *  Usage:  grow(s);
+ *  Description: This private method doubles the table and reinserts every
+ *  occupied slot.
+ */
+void grow(EDGESET *s) {
+    SLOT *old = s->slots;
+    int oldCapacity = s->capacity;
+    s->capacity *= 2;
+    s->shift--;
+    s->slots = malloc(sizeof(SLOT) * s->capacity);
+    assert(s->slots != 0);
+    for (int i = 0; i < s->capacity; i++) s->slots[i].key = EMPTY_KEY;
+    s->longest = 0;
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i].key == EMPTY_KEY) continue;
+        SLOT *slot = probe(s, old[i].key);
+        *slot = old[i];
+        noteProbe(s, slot, old[i].key);
+    }
+    free(old);
+}
+
+
+/*
+ *  Method (private):   keep
+ *  Usage:  return keep(s, &slot->weight, weight);
+ *  Description: This private method applies the parallel edge policy to an
+ *  edge that is already in the set.
+ */
+int keep(EDGESET *s, int *stored, int weight) {
+    if (s->policy == EDGESET_MINIMUM && weight < *stored) {
+        *stored = weight;
+        return EDGESET_LOWERED;
+    }
+    return EDGESET_DUPLICATE;
+}
+
+
+/*
+ *  Method (private):   noteProbe
+ *  Usage:  noteProbe(s, slot, key);
+ *  Description: This private method records the probe length of a key just
+ *  placed in slot, if it is the longest so far.
+ */
+void noteProbe(EDGESET *s, SLOT *slot, uint64_t key) {
+    int home = (key * 0x9E3779B97F4A7C15ULL) >> s->shift;
+    int length = (((int) (slot - s->slots) - home) & (s->capacity - 1)) + 1;
+    if (length > s->longest) s->longest = length;
+}
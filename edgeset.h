@@ -0,0 +1,33 @@
+/*
+ *  File:   edgeset.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the edgeset module, a flat
+ *  open-addressing hash set of undirected edges. Each edge is keyed on the
+ *  packed 64-bit integer (min(u,v) << 32) | max(u,v), so (u,v) and (v,u)
+ *  are found with a single probe sequence and no EDGE is ever allocated.
+ */
+
+#ifndef __EDGESET_INCLUDED__
+#define __EDGESET_INCLUDED__
+
+#include <stdio.h>
+
+/* policies for parallel edges */
+#define EDGESET_FIRST 0     /* keep the first-seen copy */
+#define EDGESET_MINIMUM 1   /* keep the minimum-weight copy */
+
+/* results of insertEDGESET */
+#define EDGESET_DUPLICATE 0 /* edge already present, stored weight kept */
+#define EDGESET_ADDED 1     /* edge was not present and has been added */
+#define EDGESET_LOWERED 2   /* edge already present, stored weight lowered */
+
+typedef struct EDGESET EDGESET;
+
+extern EDGESET *newEDGESET(int policy);
+extern int insertEDGESET(EDGESET *s, int u, int v, int weight);
+extern int findEDGESET(EDGESET *s, int u, int v, int *weight);
+extern int sizeEDGESET(EDGESET *s);
+extern void statisticsEDGESET(EDGESET *s, FILE *fp);
+extern void freeEDGESET(EDGESET *s);
+
+#endif // !__EDGESET_INCLUDED__
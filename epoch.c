@@ -0,0 +1,216 @@
+/*
+ *  File:   epoch.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the epoch module. The
+ *  global epoch only advances when every active slot has observed it, so
+ *  memory retired in epoch e is unreachable by the time the epoch is e + 2.
+ *  Each slot keeps three limbo lists, one per epoch modulo three, and only
+ *  its owning thread touches them.
+ */
+
+#include "epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#define ADVANCE_INTERVAL 64     /* retires between attempts to advance */
+
+
+/*
+ *  Type:   LIMBO
+ *  Description: This is a retired allocation waiting to be freed.
+ */
+typedef struct limbo {
+    void *item;
+    void (*free)(void *);
+    struct limbo *next;
+} LIMBO;
+
+
+/*
+ *  Type:   SLOT
+ *  Description: This is the per-thread state. Slots are cache-line aligned
+ *  so that readers entering and leaving do not share lines.
+ */
+typedef struct slot {
+    _Alignas(64) atomic_long epoch;
+    atomic_int active;
+    LIMBO *limbo[3];
+    long limboEpoch[3];
+    int retired;
+} SLOT;
+
+
+// EPOCH private method prototypes
+static int tryAdvance(EPOCH *e);
+static void drain(SLOT *s, int i);
+
+
+/*
+ *  Type:   EPOCH
+ *  Description: This is the struct definition for the EPOCH class.
+ */
+struct EPOCH {
+    atomic_long global;
+    atomic_int slots;
+    SLOT slot[EPOCH_SLOTS];
+};
+
+
+/*
+ *  Constructor: newEPOCH
+ *  Usage:  EPOCH *e = newEPOCH();
+ *  Description: This is the constructor used to instantiate a new EPOCH
+ *  object.
+ */
+EPOCH *newEPOCH(void) {
+    EPOCH *e = aligned_alloc(64, sizeof(EPOCH));
+    assert(e != 0);
+    atomic_init(&e->global, 0);
+    atomic_init(&e->slots, 0);
+    for (int i = 0; i < EPOCH_SLOTS; i++) {
+        atomic_init(&e->slot[i].epoch, 0);
+        atomic_init(&e->slot[i].active, 0);
+        for (int j = 0; j < 3; j++) {
+            e->slot[i].limbo[j] = NULL;
+            e->slot[i].limboEpoch[j] = 0;
+        }
+        e->slot[i].retired = 0;
+    }
+    return e;
+}
+
+
+/*
+ *  Method: registerEPOCH
+ *  Usage:  int slot = registerEPOCH(e);
+ *  Description: This method hands out a slot to the calling thread. A slot
+ *  must only be used by one thread at a time.
+ */
+int registerEPOCH(EPOCH *e) {
+    assert(e != 0);
+    int slot = atomic_fetch_add(&e->slots, 1);
+    assert(slot < EPOCH_SLOTS);
+    return slot;
+}
+
+
+/*
+ *  Method: enterEPOCH
+ *  Usage:  enterEPOCH(e, slot);
+ *  Description: This method marks the start of a read. Nothing reachable
+ *  from shared pointers loaded after this call is freed before the matching
+ *  exitEPOCH.
+ */
+void enterEPOCH(EPOCH *e, int slot) {
+    assert(e != 0);
+    SLOT *s = &e->slot[slot];
+    atomic_store(&s->epoch, atomic_load(&e->global));
+    atomic_store(&s->active, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+
+/*
+ *  Method: exitEPOCH
+ *  Usage:  exitEPOCH(e, slot);
+ *  Description: This method marks the end of a read.
+ */
+void exitEPOCH(EPOCH *e, int slot) {
+    assert(e != 0);
+    atomic_store_explicit(&e->slot[slot].active, 0, memory_order_release);
+}
+
+
+/*
+ *  Method: retireEPOCH
+ *  Usage:  retireEPOCH(e, slot, node, free);
+ *  Description: This method hands memory that has already been unlinked to
+ *  the reclaimer, which calls the freeing function once no reader can hold
+ *  it. Every so often the caller also tries to advance the global epoch.
+ */
+void retireEPOCH(EPOCH *e, int slot, void *item, void (*f)(void *)) {
+    assert(e != 0);
+    SLOT *s = &e->slot[slot];
+    if (++s->retired % ADVANCE_INTERVAL == 0) tryAdvance(e);
+    long g = atomic_load(&e->global);
+    int i = g % 3;
+    // Anything in this list is from epoch g - 3 or earlier
+    if (s->limboEpoch[i] != g) {
+        drain(s, i);
+        s->limboEpoch[i] = g;
+    }
+    // The list two epochs back is also safe by now
+    int old = (g + 1) % 3;
+    if (s->limboEpoch[old] <= g - 2) drain(s, old);
+    LIMBO *l = malloc(sizeof(LIMBO));
+    assert(l != 0);
+    l->item = item;
+    l->free = f;
+    l->next = s->limbo[i];
+    s->limbo[i] = l;
+}
+
+
+/*
+ *  Method: currentEPOCH
+ *  Usage:  long epoch = currentEPOCH(e);
+ *  Description: This method returns the global epoch.
+ */
+long currentEPOCH(EPOCH *e) {
+    assert(e != 0);
+    return atomic_load(&e->global);
+}
+
+
+/*
+ *  Method: freeEPOCH
+ *  Usage:  freeEPOCH(e);
+ *  Description: This method frees everything still in limbo and the EPOCH
+ *  object itself. No thread may be reading when it is called.
+ */
+void freeEPOCH(EPOCH *e) {
+    assert(e != 0);
+    for (int i = 0; i < EPOCH_SLOTS; i++) {
+        for (int j = 0; j < 3; j++) drain(&e->slot[i], j);
+    }
+    free(e);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   tryAdvance
+ *  Usage:  tryAdvance(e);
+ *  Description: This private method moves the global epoch forward if every
+ *  active slot has entered the current one, and returns true if it did.
+ */
+int tryAdvance(EPOCH *e) {
+    long g = atomic_load(&e->global);
+    int slots = atomic_load(&e->slots);
+    for (int i = 0; i < slots && i < EPOCH_SLOTS; i++) {
+        SLOT *s = &e->slot[i];
+        if (atomic_load(&s->active) && atomic_load(&s->epoch) != g) return 0;
+    }
+    return atomic_compare_exchange_strong(&e->global, &g, g + 1);
+}
+
+
+/*
+ *  Method (private):   drain
+ *  Usage:  drain(s, i);
+ *  Description: This private method frees every item in limbo list i.
+ */
+void drain(SLOT *s, int i) {
+    LIMBO *l = s->limbo[i];
+    while (l != NULL) {
+        LIMBO *next = l->next;
+        if (l->free != NULL) l->free(l->item);
+        free(l);
+        l = next;
+    }
+    s->limbo[i] = NULL;
+}
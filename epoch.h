@@ -0,0 +1,26 @@
+/*
+ *  File:   epoch.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the epoch module, an
+ *  epoch-based reclamation scheme for lock-free readers. A thread registers
+ *  once for a slot, brackets each read with enterEPOCH and exitEPOCH, and
+ *  retires unlinked memory instead of freeing it. Retired memory is freed
+ *  once every reader that could still see it has left its epoch.
+ */
+
+#ifndef __EPOCH_INCLUDED__
+#define __EPOCH_INCLUDED__
+
+#define EPOCH_SLOTS 64
+
+typedef struct EPOCH EPOCH;
+
+extern EPOCH *newEPOCH(void);
+extern int registerEPOCH(EPOCH *);
+extern void enterEPOCH(EPOCH *, int);
+extern void exitEPOCH(EPOCH *, int);
+extern void retireEPOCH(EPOCH *, int, void *, void (*)(void *));
+extern long currentEPOCH(EPOCH *);
+extern void freeEPOCH(EPOCH *);
+
+#endif // !__EPOCH_INCLUDED__
@@ -0,0 +1,171 @@
+/*
+ *  File:   graph.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the graph module. The
+ *  rows are laid out with a counting sort: one pass over the edges counts
+ *  each vertex's degree, a prefix sum turns the counts into the offset of
+ *  each row, and a second pass drops both halves of every edge into place.
+ *  The sort is stable, so each row lists its edges in the order they were
+ *  given. A self-loop appears twice in its vertex's row, once for each
+ *  end, as it would in an adjacency list.
+ */
+
+#include "graph.h"
+#include <stdlib.h>
+#include <assert.h>
+
+
+/*
+ *  Type:   GRAPH
+ *  Description: This is the struct definition for the GRAPH class. Row v
+ *  is targets[offsets[v]] up to targets[offsets[v + 1]], with the matching
+ *  weights at the same positions.
+ */
+struct GRAPH {
+    int vertices;
+    long edges;
+    long *offsets;
+    int *targets;
+    int *weights;
+};
+
+
+/*
+ *  Constructor: newGRAPH
+ *  Usage:  GRAPH *g = newGRAPH(n, edges, m);
+ *  Description: This is the constructor used to build a graph on vertices
+ *  0 through vertices - 1 from the given edges, which must name vertices
+ *  in that range. The edges are copied, so the caller keeps them. This
+ *  method runs in linear time.
+ */
+GRAPH *newGRAPH(int vertices, PGBEDGE *edges, long count) {
+    assert(vertices >= 0 && count >= 0);
+    GRAPH *g = malloc(sizeof(GRAPH));
+    assert(g != 0);
+    g->vertices = vertices;
+    g->edges = count;
+    g->offsets = calloc(vertices + 1, sizeof(long));
+    g->targets = malloc(sizeof(int) * (2 * count > 0 ? 2 * count : 1));
+    g->weights = malloc(sizeof(int) * (2 * count > 0 ? 2 * count : 1));
+    assert(g->offsets != 0 && g->targets != 0 && g->weights != 0);
+    // Count each row's entries one place ahead, so that the prefix sum
+    // leaves offsets[v] at the start of row v
+    for (long i = 0; i < count; i++) {
+        assert(edges[i].u < (uint32_t) vertices && edges[i].v < (uint32_t) vertices);
+        g->offsets[edges[i].u + 1]++;
+        g->offsets[edges[i].v + 1]++;
+    }
+    for (int v = 0; v < vertices; v++) g->offsets[v + 1] += g->offsets[v];
+    // Fill each row from its start, keeping a cursor per row
+    long *next = malloc(sizeof(long) * (vertices > 0 ? vertices : 1));
+    assert(next != 0);
+    for (int v = 0; v < vertices; v++) next[v] = g->offsets[v];
+    for (long i = 0; i < count; i++) {
+        int u = edges[i].u;
+        int v = edges[i].v;
+        long at = next[u]++;
+        g->targets[at] = v;
+        g->weights[at] = edges[i].weight;
+        at = next[v]++;
+        g->targets[at] = u;
+        g->weights[at] = edges[i].weight;
+    }
+    free(next);
+    return g;
+}
+
+
+/*
+ *  Method: verticesGRAPH
+ *  Usage:  int n = verticesGRAPH(g);
+ *  Description: This method returns the number of vertices.
+ */
+int verticesGRAPH(GRAPH *g) {
+    assert(g != 0);
+    return g->vertices;
+}
+
+
+/*
+ *  Method: sizeGRAPH
+ *  Usage:  long m = sizeGRAPH(g);
+ *  Description: This method returns the number of edges.
+ */
+long sizeGRAPH(GRAPH *g) {
+    assert(g != 0);
+    return g->edges;
+}
+
+
+/*
+ *  Method: degreeGRAPH
+ *  Usage:  int d = degreeGRAPH(g, v);
+ *  Description: This method returns the number of entries in row v.
+ */
+int degreeGRAPH(GRAPH *g, int v) {
+    assert(g != 0);
+    assert(v >= 0 && v < g->vertices);
+    return g->offsets[v + 1] - g->offsets[v];
+}
+
+
+/*
+ *  Method: neighborsGRAPH
+ *  Usage:  int *neighbors = neighborsGRAPH(g, v);
+ *  Description: This method returns the neighbors of v, degreeGRAPH(g, v)
+ *  of them, in the order their edges were given. They belong to the graph.
+ */
+int *neighborsGRAPH(GRAPH *g, int v) {
+    assert(g != 0);
+    assert(v >= 0 && v < g->vertices);
+    return g->targets + g->offsets[v];
+}
+
+
+/*
+ *  Method: weightsGRAPH
+ *  Usage:  int *weights = weightsGRAPH(g, v);
+ *  Description: This method returns the weights of the edges to the
+ *  neighbors of v, in the same order. They belong to the graph.
+ */
+int *weightsGRAPH(GRAPH *g, int v) {
+    assert(g != 0);
+    assert(v >= 0 && v < g->vertices);
+    return g->weights + g->offsets[v];
+}
+
+
+/*
+ *  Method: statisticsGRAPH
+ *  Usage:  statisticsGRAPH(g, stdout);
+ *  Description: This method displays the number of vertices and edges and
+ *  the largest degree.
+ *  Example Output:
+ *                  Vertices: 10
+ *                  Edges: 25
+ *                  Largest degree: 7
+ */
+void statisticsGRAPH(GRAPH *g, FILE *fp) {
+    assert(g != 0);
+    int largest = 0;
+    for (int v = 0; v < g->vertices; v++) {
+        if (degreeGRAPH(g, v) > largest) largest = degreeGRAPH(g, v);
+    }
+    fprintf(fp, "Vertices: %d\n", g->vertices);
+    fprintf(fp, "Edges: %ld\n", g->edges);
+    fprintf(fp, "Largest degree: %d\n", largest);
+}
+
+
+/*
+ *  Method: freeGRAPH
+ *  Usage:  freeGRAPH(g);
+ *  Description: This method frees the arrays and the GRAPH itself.
+ */
+void freeGRAPH(GRAPH *g) {
+    assert(g != 0);
+    free(g->offsets);
+    free(g->targets);
+    free(g->weights);
+    free(g);
+}
@@ -0,0 +1,35 @@
+/*
+ *  File:   graph.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the graph module, an
+ *  undirected weighted graph in compressed sparse row form. Vertices are
+ *  numbered densely from 0, and each one's neighbors and the weights of
+ *  the edges to them sit side by side in two flat arrays:
+ *
+ *      for (int i = 0; i < degreeGRAPH(g, u); i++) {
+ *          int v = neighborsGRAPH(g, u)[i];
+ *          int w = weightsGRAPH(g, u)[i];
+ *          ...
+ *      }
+ *
+ *  A graph is built once from a list of edges and does not change after.
+ */
+
+#ifndef __GRAPH_INCLUDED__
+#define __GRAPH_INCLUDED__
+
+#include <stdio.h>
+#include "pgb.h"
+
+typedef struct GRAPH GRAPH;
+
+extern GRAPH *newGRAPH(int vertices, PGBEDGE *edges, long count);
+extern int verticesGRAPH(GRAPH *g);
+extern long sizeGRAPH(GRAPH *g);
+extern int degreeGRAPH(GRAPH *g, int v);
+extern int *neighborsGRAPH(GRAPH *g, int v);
+extern int *weightsGRAPH(GRAPH *g, int v);
+extern void statisticsGRAPH(GRAPH *g, FILE *fp);
+extern void freeGRAPH(GRAPH *g);
+
+#endif // !__GRAPH_INCLUDED__
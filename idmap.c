@@ -0,0 +1,189 @@
+/*
+ *  File:   idmap.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the idmap module. The
+ *  forward map is a power-of-two array of (id, dense) slots probed linearly
+ *  from a multiplicative hash of the id, with a dense number of -1 marking
+ *  an empty slot so that every int can be an id. The reverse map is a
+ *  plain array indexed by dense number.
+ */
+
+#include "idmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define INITIAL_CAPACITY 1024
+
+typedef struct slot {
+    int id;
+    int dense;
+} SLOT;
+
+
+// IDMAP private method prototypes
+static SLOT *probe(IDMAP *m, int id);
+static void grow(IDMAP *m);
+
+
+/*
+ *  Type:   IDMAP
+ *  Description: This is the struct definition for the IDMAP class.
+ */
+struct IDMAP {
+    SLOT *slots;
+    int capacity;
+    int shift;
+    int *ids;
+    int size;
+    int idsCapacity;
+};
+
+
+/*
+ *  Constructor: newIDMAP
+ *  Usage:  IDMAP *m = newIDMAP();
+ *  Description: This is the constructor used to instantiate a new, empty
+ *  IDMAP object.
+ */
+IDMAP *newIDMAP(void) {
+    IDMAP *m = malloc(sizeof(IDMAP));
+    assert(m != 0);
+    m->capacity = INITIAL_CAPACITY;
+    m->shift = 64 - 10;
+    m->slots = malloc(sizeof(SLOT) * m->capacity);
+    assert(m->slots != 0);
+    for (int i = 0; i < m->capacity; i++) m->slots[i].dense = -1;
+    m->idsCapacity = INITIAL_CAPACITY;
+    m->ids = malloc(sizeof(int) * m->idsCapacity);
+    assert(m->ids != 0);
+    m->size = 0;
+    return m;
+}
+
+
+/*
+ *  Method: insertIDMAP
+ *  Usage:  int dense = insertIDMAP(m, id);
+ *  Description: This method returns the dense number of id, giving it the
+ *  next one if it has not been seen before. This method runs in amortized
+ *  constant time.
+ */
+int insertIDMAP(IDMAP *m, int id) {
+    assert(m != 0);
+    SLOT *slot = probe(m, id);
+    if (slot->dense >= 0) return slot->dense;
+    if (m->size == m->idsCapacity) {
+        m->idsCapacity *= 2;
+        m->ids = realloc(m->ids, sizeof(int) * m->idsCapacity);
+        assert(m->ids != 0);
+    }
+    slot->id = id;
+    slot->dense = m->size;
+    m->ids[m->size] = id;
+    m->size++;
+    // Keep the load factor at or below 1/2
+    if (m->size * 2 > m->capacity) grow(m);
+    return m->size - 1;
+}
+
+
+/*
+ *  Method: findIDMAP
+ *  Usage:  int dense = findIDMAP(m, id);
+ *  Description: This method returns the dense number of id, or -1 if it
+ *  has not been inserted.
+ */
+int findIDMAP(IDMAP *m, int id) {
+    assert(m != 0);
+    return probe(m, id)->dense;
+}
+
+
+/*
+ *  Method: lookupIDMAP
+ *  Usage:  int id = lookupIDMAP(m, dense);
+ *  Description: This method returns the id with the given dense number.
+ */
+int lookupIDMAP(IDMAP *m, int dense) {
+    assert(m != 0);
+    assert(dense >= 0 && dense < m->size);
+    return m->ids[dense];
+}
+
+
+/*
+ *  Method: idsIDMAP
+ *  Usage:  int *ids = idsIDMAP(m);
+ *  Description: This method returns the reverse map, the ids in order of
+ *  dense number. It belongs to the IDMAP and moves when ids are inserted.
+ */
+int *idsIDMAP(IDMAP *m) {
+    assert(m != 0);
+    return m->ids;
+}
+
+
+/*
+ *  Method: sizeIDMAP
+ *  Usage:  int n = sizeIDMAP(m);
+ *  Description: This method returns the number of distinct ids inserted.
+ */
+int sizeIDMAP(IDMAP *m) {
+    assert(m != 0);
+    return m->size;
+}
+
+
+/*
+ *  Method: freeIDMAP
+ *  Usage:  freeIDMAP(m);
+ *  Description: This method frees both maps and the IDMAP itself.
+ */
+void freeIDMAP(IDMAP *m) {
+    assert(m != 0);
+    free(m->slots);
+    free(m->ids);
+    free(m);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   probe
+ *  Usage:  SLOT *slot = probe(m, id);
+ *  Description: This private method returns the slot holding id, or the
+ *  empty slot where id belongs if it is not in the table.
+ */
+SLOT *probe(IDMAP *m, int id) {
+    int mask = m->capacity - 1;
+    int i = ((uint64_t)(uint32_t) id * 0x9E3779B97F4A7C15ULL) >> m->shift;
+    while (m->slots[i].dense >= 0 && m->slots[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    return &m->slots[i];
+}
+
+
+/*
+ *  Method (private):   grow
+ *  Usage:  grow(m);
+ *  Description: This private method doubles the table, rehashing every id
+ *  in dense order.
+ */
+void grow(IDMAP *m) {
+    free(m->slots);
+    m->capacity *= 2;
+    m->shift--;
+    m->slots = malloc(sizeof(SLOT) * m->capacity);
+    assert(m->slots != 0);
+    for (int i = 0; i < m->capacity; i++) m->slots[i].dense = -1;
+    for (int d = 0; d < m->size; d++) {
+        SLOT *slot = probe(m, m->ids[d]);
+        slot->id = m->ids[d];
+        slot->dense = d;
+    }
+}
@@ -0,0 +1,22 @@
+/*
+ *  File:   idmap.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the idmap module, which
+ *  numbers arbitrary integer vertex ids densely from zero in the order they
+ *  are first inserted, and maps the dense numbers back to the ids.
+ */
+
+#ifndef __IDMAP_INCLUDED__
+#define __IDMAP_INCLUDED__
+
+typedef struct IDMAP IDMAP;
+
+extern IDMAP *newIDMAP(void);
+extern int insertIDMAP(IDMAP *m, int id);
+extern int findIDMAP(IDMAP *m, int id);
+extern int lookupIDMAP(IDMAP *m, int dense);
+extern int *idsIDMAP(IDMAP *m);
+extern int sizeIDMAP(IDMAP *m);
+extern void freeIDMAP(IDMAP *m);
+
+#endif // !__IDMAP_INCLUDED__
@@ -0,0 +1,261 @@
+/*
+ *  File:   pgb.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the pgb module. A file
+ *  is mapped read-only and used in place: the vertex ids and the edge
+ *  records are pointers into the mapping. Loading checks the header
+ *  against the file size, then makes one pass over each section to verify
+ *  its checksum and that every edge names a vertex in the map.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "pgb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAGIC "PGB1"
+#define VERSION 1
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "pgb files are little-endian; this machine needs byte swapping added"
+#endif
+
+
+/*
+ *  Type:   HEADER
+ *  Description: This is the fixed-size start of a file.
+ */
+typedef struct header {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertices;
+    uint32_t flags;
+    uint64_t edges;
+    uint64_t idsChecksum;
+    uint64_t edgesChecksum;
+} HEADER;
+
+
+// PGB private method prototypes
+static uint64_t checksum(void *data, long bytes);
+static void formatError(char *filename, char *problem);
+
+
+/*
+ *  Type:   PGB
+ *  Description: This is the struct definition for the PGB class.
+ */
+struct PGB {
+    char *data;
+    long size;
+    HEADER *header;
+    int *ids;
+    PGBEDGE *edges;
+};
+
+
+/*
+ *  Method: isPGB
+ *  Usage:  if (isPGB("graph.pgb")) ...
+ *  Description: This method returns true if filename is a regular file
+ *  starting with the magic number. Anything else, including a pipe, is
+ *  left unread.
+ */
+int isPGB(char *filename) {
+    struct stat st;
+    if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+    FILE *fp = fopen(filename, "rb");
+    if (fp == 0) return 0;
+    char magic[4];
+    int found = fread(magic, 1, 4, fp) == 4 && memcmp(magic, MAGIC, 4) == 0;
+    fclose(fp);
+    return found;
+}
+
+
+/*
+ *  Method: writePGB
+ *  Usage:  int ok = writePGB("graph.pgb", ids, n, edges, m, PGB_DISTINCT);
+ *  Description: This method writes a graph of the given vertex ids and
+ *  edge records, returning false if the file cannot be written.
+ */
+int writePGB(char *filename, int *ids, int vertices,
+             PGBEDGE *edges, long count, int flags) {
+    assert(vertices >= 0 && count >= 0);
+    HEADER h;
+    memcpy(h.magic, MAGIC, 4);
+    h.version = VERSION;
+    h.vertices = vertices;
+    h.flags = flags;
+    h.edges = count;
+    h.idsChecksum = checksum(ids, sizeof(int) * (long) vertices);
+    h.edgesChecksum = checksum(edges, sizeof(PGBEDGE) * count);
+    FILE *fp = fopen(filename, "wb");
+    if (fp == 0) return 0;
+    int ok = fwrite(&h, sizeof(HEADER), 1, fp) == 1
+        && fwrite(ids, sizeof(int), vertices, fp) == (size_t) vertices
+        && fwrite(edges, sizeof(PGBEDGE), count, fp) == (size_t) count;
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+
+/*
+ *  Constructor: newPGB
+ *  Usage:  PGB *g = newPGB("graph.pgb");
+ *  Description: This is the constructor used to map a binary graph file.
+ *  It returns NULL if the file cannot be opened or mapped. A file that is
+ *  truncated or fails a check is reported on stderr and the program
+ *  exits, as with a malformed edge file.
+ */
+PGB *newPGB(char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size < (off_t) sizeof(HEADER)) formatError(filename, "file is too short");
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    PGB *g = malloc(sizeof(PGB));
+    assert(g != 0);
+    g->data = p;
+    g->size = st.st_size;
+    g->header = p;
+    HEADER *h = g->header;
+    if (memcmp(h->magic, MAGIC, 4) != 0) formatError(filename, "bad magic number");
+    if (h->version != VERSION) formatError(filename, "unknown format version");
+    uint64_t expected = sizeof(HEADER) + 4 * (uint64_t) h->vertices;
+    uint64_t size = g->size;
+    if (h->vertices > INT32_MAX || expected > size
+            || (size - expected) % sizeof(PGBEDGE) != 0
+            || (size - expected) / sizeof(PGBEDGE) != h->edges) {
+        formatError(filename, "size does not match the header");
+    }
+    g->ids = (int *) (g->data + sizeof(HEADER));
+    g->edges = (PGBEDGE *) (g->data + expected);
+    if (checksum(g->ids, 4 * (long) h->vertices) != h->idsChecksum) {
+        formatError(filename, "vertex map checksum mismatch");
+    }
+    if (checksum(g->edges, sizeof(PGBEDGE) * h->edges) != h->edgesChecksum) {
+        formatError(filename, "edge checksum mismatch");
+    }
+    for (uint64_t i = 0; i < h->edges; i++) {
+        if (g->edges[i].u >= h->vertices || g->edges[i].v >= h->vertices) {
+            formatError(filename, "edge names a vertex outside the map");
+        }
+    }
+    return g;
+}
+
+
+/*
+ *  Method: verticesPGB
+ *  Usage:  int n = verticesPGB(g);
+ *  Description: This method returns the number of vertices in the map.
+ */
+int verticesPGB(PGB *g) {
+    assert(g != 0);
+    return g->header->vertices;
+}
+
+
+/*
+ *  Method: flagsPGB
+ *  Usage:  if (flagsPGB(g) & PGB_DISTINCT) ...
+ *  Description: This method returns the header flags.
+ */
+int flagsPGB(PGB *g) {
+    assert(g != 0);
+    return g->header->flags;
+}
+
+
+/*
+ *  Method: idsPGB
+ *  Usage:  int *ids = idsPGB(g);
+ *  Description: This method returns the vertex ids in order of dense
+ *  number. They live in the mapping and are read-only.
+ */
+int *idsPGB(PGB *g) {
+    assert(g != 0);
+    return g->ids;
+}
+
+
+/*
+ *  Method: sizePGB
+ *  Usage:  long m = sizePGB(g);
+ *  Description: This method returns the number of edge records.
+ */
+long sizePGB(PGB *g) {
+    assert(g != 0);
+    return g->header->edges;
+}
+
+
+/*
+ *  Method: edgesPGB
+ *  Usage:  PGBEDGE *edges = edgesPGB(g);
+ *  Description: This method returns the edge records in file order. They
+ *  live in the mapping and are read-only.
+ */
+PGBEDGE *edgesPGB(PGB *g) {
+    assert(g != 0);
+    return g->edges;
+}
+
+
+/*
+ *  Method: freePGB
+ *  Usage:  freePGB(g);
+ *  Description: This method unmaps the file and frees the PGB object.
+ */
+void freePGB(PGB *g) {
+    assert(g != 0);
+    munmap(g->data, g->size);
+    free(g);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Method (private):   checksum
+ *  Usage:  uint64_t sum = checksum(data, bytes);
+ *  Description: This private method computes a Fletcher-style checksum
+ *  over 32-bit words: a running sum, and a sum of running sums so that
+ *  swapped words are caught too. bytes must be a multiple of four.
+ */
+uint64_t checksum(void *data, long bytes) {
+    uint32_t *w = data;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    for (long i = 0; i < bytes / 4; i++) {
+        a += w[i];
+        b += a;
+    }
+    return a ^ (b << 32 | b >> 32);
+}
+
+
+/*
+ *  Method (private):   formatError
+ *  Usage:  formatError(filename, "bad magic number");
+ *  Description: This private method reports a damaged file, then exits.
+ */
+void formatError(char *filename, char *problem) {
+    fprintf(stderr, "FORMAT ERROR: %s: %s\n", filename, problem);
+    exit(1);
+}
@@ -0,0 +1,50 @@
+/*
+ *  File:   pgb.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the pgb module, a binary
+ *  graph container that loads without parsing. A file holds a header, a
+ *  dense vertex-id map and packed edge records that refer to vertices by
+ *  dense number, each section covered by a checksum:
+ *
+ *      offset  size  field
+ *      0       4     magic "PGB1"
+ *      4       4     format version (1)
+ *      8       4     vertices
+ *      12      4     flags (PGB_DISTINCT)
+ *      16      8     edges
+ *      24      8     checksum of the vertex-id map
+ *      32      8     checksum of the edge records
+ *      40      4*V   vertex ids (i32), in order of dense number
+ *      ...     12*E  edge records (u32 u, u32 v, i32 weight)
+ *
+ *  All integers are little-endian.
+ */
+
+#ifndef __PGB_INCLUDED__
+#define __PGB_INCLUDED__
+
+#include <stdint.h>
+
+/* header flags */
+#define PGB_DISTINCT 1      /* no edge appears twice, in either orientation */
+
+typedef struct pgbedge {
+    uint32_t u;
+    uint32_t v;
+    int32_t weight;
+} PGBEDGE;
+
+typedef struct PGB PGB;
+
+extern int isPGB(char *filename);
+extern int writePGB(char *filename, int *ids, int vertices,
+                    PGBEDGE *edges, long count, int flags);
+extern PGB *newPGB(char *filename);
+extern int verticesPGB(PGB *g);
+extern int flagsPGB(PGB *g);
+extern int *idsPGB(PGB *g);
+extern long sizePGB(PGB *g);
+extern PGBEDGE *edgesPGB(PGB *g);
+extern void freePGB(PGB *g);
+
+#endif // !__PGB_INCLUDED__
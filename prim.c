@@ -1,28 +1,61 @@
+#define _POSIX_C_SOURCE 199309L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include <assert.h>
+#include <time.h>
 #include "vertex.h"
-#include "edge.h"
-#include "scanner.h"
-#include "avl.h"
+#include "edgeset.h"
+#include "edgefile.h"
+#include "edgepipe.h"
+#include "pgb.h"
+#include "idmap.h"
+#include "graph.h"
 #include "binomial.h"
-#include "queue.h"
 #include "integer.h"
 
 
+#define BATCH 4096  /* records tokenized at a time */
+#define SLOTS 4     /* batches queued between reader and builder */
+
 /* options */
 int vOption = 0;    /* option -v */
+int sOption = 0;    /* option -s */
+int tOption = 0;    /* option -t */
+int jOption = 1;    /* option -j N, threads used to parse */
+int pOption = 0;    /* option -p, read and parse on a separate thread */
+int COption = 0;    /* option -C, convert an edge file to a binary graph */
+int skipOption = 0; /* option --skip-bad-records, log and skip bad records */
+
+/* the edges prim keeps, with vertices numbered densely as first seen */
+typedef struct edgelist {
+    IDMAP *ids;
+    EDGESET *seen;
+    PGBEDGE *records;
+    long count;
+    long capacity;
+} EDGELIST;
 
 static int processOptions(int, char **);
-static VERTEX *processEdgeFile(BINOMIAL *, AVL *, AVL *, FILE *);
-static VERTEX *addVertex(BINOMIAL *, AVL *, int);
-static void addEdge(BINOMIAL *, AVL *, AVL *, int, int, int);
+static void processEdgeFile(EDGELIST *, EDGEFILE *);
+static void processEdgePipe(EDGELIST *, EDGEPIPE *);
+static void processGraphFile(EDGELIST *, PGB *);
+static void convertEdgeFile(char *, char *);
+static void timeEdgeFile(EDGEFILE *);
+static int policy(void);
+static EDGELIST *newEdgeList(void);
+static void addEdges(EDGELIST *, EDGETRIPLE *, int);
+static void addEdge(EDGELIST *, int, int, int);
+static void freeEdgeList(EDGELIST *);
+static VERTEX **addVertices(BINOMIAL *, IDMAP *);
 static void Fatal(char *,...);
 static void printAuthor(void);
 static void update(void *, void *);
-static void primMST(BINOMIAL *, VERTEX *);
+static void primMST(BINOMIAL *, GRAPH *, IDMAP *, VERTEX **, VERTEX *);
 static void displayMST(VERTEX *);
+static double now(void);
 
 
 int main(int argc,char **argv) {
@@ -36,34 +69,75 @@ int main(int argc,char **argv) {
 
     // Open edge file for reading
     char *edgeFilename = argv[argIndex];
-    FILE *edgeFP = fopen(edgeFilename, "r");
-    if (edgeFP == 0) {
+    if (COption) {
+        if (argIndex + 1 >= argc) Fatal("option -C needs an input and an output file\n");
+        convertEdgeFile(edgeFilename, argv[argIndex + 1]);
+        return 0;
+    }
+    PGB *graphFile = NULL;
+    EDGEFILE *edgeFile = NULL;
+    EDGEPIPE *edgePipe = NULL;
+    if (isPGB(edgeFilename)) graphFile = newPGB(edgeFilename);
+    else if (pOption) edgePipe = newEDGEPIPE(edgeFilename, SLOTS, policy());
+    else edgeFile = newEDGEFILE(edgeFilename);
+    if (graphFile == 0 && edgeFile == 0 && edgePipe == 0) {
         Fatal("Unable to open %s for reading!\n", edgeFilename);
     }
+    if (edgeFile) skipEDGEFILE(edgeFile, policy());
     // Process Edge File
-    AVL *vertices = newAVL(displayVERTEX, compareVERTEX, freeVERTEX);
-    AVL *edges = newAVL(displayEDGE, compareEDGE, freeEDGE);
+    EDGELIST *edges = newEdgeList();
     BINOMIAL *heap = newBINOMIAL(displayVERTEX, compareVERTEX, update, 0);
-    VERTEX *source = processEdgeFile(heap, vertices, edges, edgeFP);
-    fclose(edgeFP);
+    // A stream cannot be read twice, so it only gets the overall time
+    if (tOption && edgeFile && !streamingEDGEFILE(edgeFile)) timeEdgeFile(edgeFile);
+    double start = now();
+    if (graphFile) processGraphFile(edges, graphFile);
+    else if (edgePipe) processEdgePipe(edges, edgePipe);
+    else processEdgeFile(edges, edgeFile);
+    // The source was numbered first, so it is vertex 0
+    GRAPH *graph = newGRAPH(sizeIDMAP(edges->ids), edges->records, edges->count);
+    VERTEX **byNumber = addVertices(heap, edges->ids);
+    VERTEX *source = edges->count > 0 ? byNumber[0] : NULL;
+    if (tOption) fprintf(stderr, "Loaded graph in %.3f s\n", now() - start);
+    if (skipOption) {
+        long skipped = edgePipe ? skippedEDGEPIPE(edgePipe) : edgeFile ? skippedEDGEFILE(edgeFile) : 0;
+        fprintf(stderr, "Skipped %ld bad record%s\n", skipped, skipped == 1 ? "" : "s");
+    }
+    if (tOption && edgePipe) {
+        double reader;
+        double builder;
+        stallEDGEPIPE(edgePipe, &reader, &builder);
+        fprintf(stderr, "Reader stalled %.3f s, builder stalled %.3f s\n", reader, builder);
+    }
+    if (graphFile) freePGB(graphFile);
+    else if (edgePipe) freeEDGEPIPE(edgePipe);
+    else freeEDGEFILE(edgeFile);
+
+    if (sOption) {
+        // Dump the structures' statistics, which are all kept up to date
+        statisticsGRAPH(graph, stderr);
+        statisticsEDGESET(edges->seen, stderr);
+    }
 
     // Check if edge file was empty
     if (source == NULL) {
         printf("EMPTY\n");
-        freeAVL(vertices);
-        freeAVL(edges);
+        free(byNumber);
+        freeGRAPH(graph);
+        freeEdgeList(edges);
         return 0;
     }
 
 
     // Find MST
-    primMST(heap, source);
+    start = now();
+    primMST(heap, graph, edges->ids, byNumber, source);
+    if (tOption) fprintf(stderr, "Found MST in %.3f s\n", now() - start);
     displayMST(source);
 
     /*
     freeVERTEX(source);
-    freeAVL(vertices);
-    freeAVL(edges);
+    freeGRAPH(graph);
+    freeEdgeList(edges);
     */
     return 0;
 }
@@ -84,10 +158,32 @@ static int processOptions(int argc, char **argv) {
         /* check if stdin, represented by "-" is an argument */
         /* if so, the end of options has been reached */
         if (argv[argIndex][1] == '\0') return argIndex;
+        if (strcmp(argv[argIndex], "--skip-bad-records") == 0) {
+            skipOption = 1;
+            ++argIndex;
+            continue;
+        }
         switch (argv[argIndex][1]) {
             case 'v':
                 vOption = 1;
                 break;
+            case 's':
+                sOption = 1;
+                break;
+            case 't':
+                tOption = 1;
+                break;
+            case 'C':
+                COption = 1;
+                break;
+            case 'p':
+                pOption = 1;
+                break;
+            case 'j':
+                if (argIndex + 1 == argc) Fatal("option -j needs a thread count\n");
+                jOption = atoi(argv[++argIndex]);
+                if (jOption < 1) Fatal("option -j needs a positive thread count\n");
+                break;
             default:
                 Fatal("option %s not understood\n",argv[argIndex]);
         }
@@ -96,61 +192,150 @@ static int processOptions(int argc, char **argv) {
     return argIndex;
 }
 
-static VERTEX *processEdgeFile(BINOMIAL *heap, AVL *vertices, AVL *edges, FILE *fp) {
-    assert(vertices != 0);
-    VERTEX *source = NULL;
-    int v1;
-    int v2;
-    int weight;
-    char ch;
-    v1 = readInt(fp);
-    while (!feof(fp)) {
-        if (source == NULL) source = addVertex(heap, vertices, v1);
-        v2 = readInt(fp);
-        ch = readChar(fp);
-        if (ch != ';') {
-            ungetc(ch, fp);
-            weight = readInt(fp);
-            ch = readChar(fp); // trash
+static void processEdgeFile(EDGELIST *edges, EDGEFILE *f) {
+    assert(edges != 0);
+    if (jOption > 1) {
+        // Parse everything across threads first, then keep in file order
+        long count;
+        EDGETRIPLE *all = readEDGEFILEparallel(f, jOption, &count);
+        for (long i = 0; i < count; i += BATCH) {
+            addEdges(edges, all + i, count - i < BATCH ? count - i : BATCH);
+        }
+        free(all);
+        return;
+    }
+    static EDGETRIPLE batch[BATCH];
+    int n;
+    while ((n = readEDGEFILEbatch(f, batch, BATCH)) > 0) addEdges(edges, batch, n);
+}
+
+static void processEdgePipe(EDGELIST *edges, EDGEPIPE *p) {
+    assert(edges != 0);
+    EDGETRIPLE *batch;
+    int n;
+    while ((n = nextEDGEPIPE(p, &batch)) > 0) addEdges(edges, batch, n);
+}
+
+static void processGraphFile(EDGELIST *edges, PGB *g) {
+    assert(edges != 0);
+    // The map is in first-seen order, so numbering it in order gives each
+    // vertex the number it would get from the edge file
+    int n = verticesPGB(g);
+    int *ids = idsPGB(g);
+    for (int i = 0; i < n; i++) insertIDMAP(edges->ids, ids[i]);
+    PGBEDGE *e = edgesPGB(g);
+    long m = sizePGB(g);
+    if (flagsPGB(g) & PGB_DISTINCT) {
+        // The writer already dropped the repeats and numbered the records,
+        // so they are copied as they are instead of being hashed again
+        if (m > edges->capacity) {
+            edges->capacity = m;
+            edges->records = realloc(edges->records, sizeof(PGBEDGE) * edges->capacity);
+            assert(edges->records != 0);
         }
-        else weight = 1;
-        addEdge(heap, vertices, edges, v1, v2, weight);
-        v1 = readInt(fp);
+        memcpy(edges->records, e, sizeof(PGBEDGE) * m);
+        edges->count = m;
+        return;
     }
-    return source;
+    for (long i = 0; i < m; i++) addEdge(edges, ids[e[i].u], ids[e[i].v], e[i].weight);
 }
 
-static VERTEX *addVertex(BINOMIAL *heap, AVL *vertices, int v) {
-    assert(vertices != 0);
-    VERTEX *temp = newVERTEX(v);
-    VERTEX *rv = findAVL(vertices, temp);
-    if (rv) {
-        freeVERTEX(temp);
+static void convertEdgeFile(char *inName, char *outName) {
+    // Keeps the edges prim would keep, numbering vertices as prim does
+    EDGEFILE *f = newEDGEFILE(inName);
+    if (f == 0) Fatal("Unable to open %s for reading!\n", inName);
+    skipEDGEFILE(f, policy());
+    EDGELIST *edges = newEdgeList();
+    processEdgeFile(edges, f);
+    if (skipOption) {
+        long skipped = skippedEDGEFILE(f);
+        fprintf(stderr, "Skipped %ld bad record%s\n", skipped, skipped == 1 ? "" : "s");
+    }
+    if (!writePGB(outName, idsIDMAP(edges->ids), sizeIDMAP(edges->ids),
+                  edges->records, edges->count, PGB_DISTINCT)) {
+        Fatal("Unable to write %s!\n", outName);
+    }
+    freeEdgeList(edges);
+    freeEDGEFILE(f);
+}
+
+static void timeEdgeFile(EDGEFILE *f) {
+    // Times a parse-only pass, so that graph building does not count
+    static char *paths[] = { "scalar", "SSE4.2", "AVX2" };
+    static EDGETRIPLE batch[BATCH];
+    int path = simdEDGEFILE(f, EDGEFILE_AVX2);
+    // Bad records are logged by the real pass, not this one
+    skipEDGEFILE(f, skipOption ? EDGEFILE_SKIP_QUIETLY : EDGEFILE_STOP);
+    double start = now();
+    if (jOption > 1) {
+        long count;
+        free(readEDGEFILEparallel(f, jOption, &count));
     }
     else {
-        insertAVL(vertices, temp);
-        setVERTEXowner(temp, insertBINOMIAL(heap, temp));
-        rv = temp;
+        while (readEDGEFILEbatch(f, batch, BATCH) > 0) continue;
     }
-    return rv;
+    double seconds = now() - start;
+    double megabytes = sizeEDGEFILE(f) / 1e6;
+    fprintf(stderr, "Parsed %.1f MB in %.3f s (%.1f MB/s, %s, %d thread%s)\n",
+            megabytes, seconds, seconds > 0 ? megabytes / seconds : 0.0, paths[path],
+            jOption, jOption == 1 ? "" : "s");
+    rewindEDGEFILE(f);
+    skipEDGEFILE(f, policy());
 }
 
-static void addEdge(BINOMIAL *heap, AVL *vertices, AVL *edges, int u, int v, int w) {
+static int policy(void) {
+    return skipOption ? EDGEFILE_SKIP : EDGEFILE_STOP;
+}
+
+static EDGELIST *newEdgeList(void) {
+    EDGELIST *edges = malloc(sizeof(EDGELIST));
     assert(edges != 0);
-    EDGE *edgeUV = newEDGE(u, v, w);
-    EDGE *edgeVU = newEDGE(v, u, w);
-    if (findAVL(edges, edgeUV) || findAVL(edges, edgeVU)) {
-        freeEDGE(edgeUV);
-        freeEDGE(edgeVU);
-        return;
+    edges->ids = newIDMAP();
+    edges->seen = newEDGESET(EDGESET_FIRST);
+    edges->count = 0;
+    edges->capacity = BATCH;
+    edges->records = malloc(sizeof(PGBEDGE) * edges->capacity);
+    assert(edges->records != 0);
+    return edges;
+}
+
+static void addEdges(EDGELIST *edges, EDGETRIPLE *batch, int n) {
+    // The first vertex in the file is the source, so it is numbered first
+    if (n > 0 && sizeIDMAP(edges->ids) == 0) insertIDMAP(edges->ids, batch[0].u);
+    for (int i = 0; i < n; i++) addEdge(edges, batch[i].u, batch[i].v, batch[i].weight);
+}
+
+static void addEdge(EDGELIST *edges, int u, int v, int w) {
+    // The first-seen copy of an edge wins, in either orientation
+    if (insertEDGESET(edges->seen, u, v, w) != EDGESET_ADDED) return;
+    if (edges->count == edges->capacity) {
+        edges->capacity *= 2;
+        edges->records = realloc(edges->records, sizeof(PGBEDGE) * edges->capacity);
+        assert(edges->records != 0);
     }
-    insertAVL(edges, edgeUV);
-    VERTEX *v1 = addVertex(heap, vertices, u);
-    VERTEX *v2 = addVertex(heap, vertices, v);
-    insertVERTEXneighbor(v1, v2);
-    insertVERTEXweight(v1, w);
-    insertVERTEXneighbor(v2, v1);
-    insertVERTEXweight(v2, w);
+    PGBEDGE *e = &edges->records[edges->count++];
+    e->u = insertIDMAP(edges->ids, u);
+    e->v = insertIDMAP(edges->ids, v);
+    e->weight = w;
+}
+
+static void freeEdgeList(EDGELIST *edges) {
+    freeIDMAP(edges->ids);
+    freeEDGESET(edges->seen);
+    free(edges->records);
+    free(edges);
+}
+
+static VERTEX **addVertices(BINOMIAL *heap, IDMAP *ids) {
+    // Vertex i is the one numbered i, and they join the heap in that order
+    int n = sizeIDMAP(ids);
+    VERTEX **byNumber = malloc(sizeof(VERTEX *) * (n > 0 ? n : 1));
+    assert(byNumber != 0);
+    for (int i = 0; i < n; i++) {
+        byNumber[i] = newVERTEX(lookupIDMAP(ids, i));
+        setVERTEXowner(byNumber[i], insertBINOMIAL(heap, byNumber[i]));
+    }
+    return byNumber;
 }
 
 static void printAuthor(void) {
@@ -163,13 +348,11 @@ static void update(void *v, void *n) {
     setVERTEXowner(p, n);
 }
 
-static void primMST(BINOMIAL *heap, VERTEX *source) {
+static void primMST(BINOMIAL *heap, GRAPH *graph, IDMAP *ids, VERTEX **byNumber, VERTEX *source) {
     assert(heap != 0);
     assert(source != 0);
     VERTEX *u;
     VERTEX *v;
-    DLL *neighbors;
-    DLL *weights;
     setVERTEXkey(source, 0);
     decreaseKeyBINOMIAL(heap, getVERTEXowner(source), source);
     while (sizeBINOMIAL(heap) > 0) {
@@ -179,14 +362,14 @@ static void primMST(BINOMIAL *heap, VERTEX *source) {
             insertVERTEXsuccessor(getVERTEXpred(u), u);
         }
         setVERTEXflag(u, 1);
-        neighbors = getVERTEXneighbors(u);
-        weights = getVERTEXweights(u);
-        firstDLL(neighbors);
-        firstDLL(weights);
-        int weightUV;
-        while (moreDLL(neighbors)) {
-            v = currentDLL(neighbors);
-            weightUV = getINTEGER(currentDLL(weights));
+        // The neighbors and their weights are two runs of the same row
+        int row = findIDMAP(ids, getVERTEXnumber(u));
+        int degree = degreeGRAPH(graph, row);
+        int *neighbors = neighborsGRAPH(graph, row);
+        int *weights = weightsGRAPH(graph, row);
+        for (int i = 0; i < degree; i++) {
+            v = byNumber[neighbors[i]];
+            int weightUV = weights[i];
             if (!getVERTEXflag(v)) {
                 if (weightUV < getVERTEXkey(v) || getVERTEXkey(v) == -1) {
                     setVERTEXpred(v, u);
@@ -194,8 +377,6 @@ static void primMST(BINOMIAL *heap, VERTEX *source) {
                     decreaseKeyBINOMIAL(heap, getVERTEXowner(v), v);
                 }
             }
-            nextDLL(neighbors);
-            nextDLL(weights);
         }
     }
 }
@@ -249,3 +430,9 @@ static void displayMST(VERTEX *source) {
     }
     printf("weight: %d\n", totalWeight);
 }
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
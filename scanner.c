@@ -7,7 +7,7 @@
 static void *allocateMsg(size_t size,char *where);
 static void *reallocateMsg(void *s,size_t size,char *where);
 
-/* VERSION 1.3
+/* VERSION 1.4
  *
  * scanner.c - a collection of input routines for C
  *           - written by John C. Lusth
@@ -55,10 +55,43 @@ static void *reallocateMsg(void *s,size_t size,char *where);
  *      - returns true (non-zero) if the next non-whitespace character
  *        is a double quote
  *      - it consumes all the whitespace up to that non-whitespace character
+ *
+ *    the read functions above return a fresh buffer on every call; a
+ *    SCANNER instead owns one buffer and reuses it for every token, so a
+ *    loop over a long input allocates nothing once the buffer is big
+ *    enough.  Each SCANNER has its own buffer, so separate streams can be
+ *    scanned from separate threads.
+ *
+ *    newSCANNER(FILE *fp)
+ *      - returns a SCANNER reading from fp; fp is not closed by freeSCANNER
+ *      - usage example: SCANNER *s = newSCANNER(stdin);
+ *    scanToken(SCANNER *s,int *length)
+ *    scanString(SCANNER *s,int *length)
+ *    scanLine(SCANNER *s,int *length)
+ *      - read as readToken, readString and readLine do
+ *      - return a view into the SCANNER's buffer, valid until the next scan;
+ *        the caller must not free it
+ *      - store the length of the view in *length, unless length is 0
+ *      - return 0 if end of file; feof will subsequently return true
+ *      - usage example: char *x = scanToken(s,&n);
+ *    freeSCANNER(SCANNER *s)
+ *      - frees the SCANNER and its buffer
  */
 
+struct scanner
+    {
+    FILE *fp;
+    char *buffer;               //reused by every scan
+    int size;
+    };
+
 static void skipWhiteSpace(FILE *);
 static char convertEscapedChar(int);
+static int collectString(FILE *,char **,int *,char *);
+static int collectToken(FILE *,char **,int *,char *);
+static int collectLine(FILE *,char **,int *,char *);
+static void grow(char **,int *,char *);
+static char *view(SCANNER *,int,int *);
 
 /********** public functions **********************/
 
@@ -140,23 +173,144 @@ readRawChar(FILE *fp)
 char *
 readString(FILE *fp)
     {
-    int ch,index;
     char *buffer;
     int size = 512;
 
-    /* advance to the double quote */
+    buffer = allocateMsg(size,"readString");
+    if (collectString(fp,&buffer,&size,"readString") < 0)
+        {
+        free(buffer);
+        return 0;
+        }
+    return buffer;
+    }
 
-    skipWhiteSpace(fp);
+char *
+readToken(FILE *fp)
+    {
+    char *buffer;
+    int size = 80;
+
+    buffer = allocateMsg(size,"readToken");
+    if (collectToken(fp,&buffer,&size,"readToken") < 0)
+        {
+        free(buffer);
+        return 0;
+        }
+    return buffer;
+    }
 
-    if (feof(fp)) return 0;
+char *
+readLine(FILE *fp)
+    {
+    char *buffer;
+    int size = 512;
 
-    ch = fgetc(fp);
+    buffer = allocateMsg(size,"readLine");
+    if (collectLine(fp,&buffer,&size,"readLine") < 0)
+        {
+        free(buffer);
+        return 0;
+        }
+    return buffer;
+    }
 
+int
+stringPending(FILE *fp)
+    {
+    int ch,result = 0;
+    skipWhiteSpace(fp);
+    ch = fgetc(fp);
     if (ch == EOF) return 0;
+    if (ch == '\"') result = 1;
+    ungetc(ch,fp);
+    return result;
+    }
 
-    /* allocate the buffer */
+SCANNER *
+newSCANNER(FILE *fp)
+    {
+    SCANNER *s = allocateMsg(sizeof(SCANNER),"newSCANNER");
+    s->fp = fp;
+    s->size = 80;
+    s->buffer = allocateMsg(s->size,"newSCANNER");
+    s->buffer[0] = '\0';
+    return s;
+    }
 
-    buffer = allocateMsg(size,"readString");
+char *
+scanToken(SCANNER *s,int *length)
+    {
+    return view(s,collectToken(s->fp,&s->buffer,&s->size,"scanToken"),length);
+    }
+
+char *
+scanString(SCANNER *s,int *length)
+    {
+    return view(s,collectString(s->fp,&s->buffer,&s->size,"scanString"),length);
+    }
+
+char *
+scanLine(SCANNER *s,int *length)
+    {
+    return view(s,collectLine(s->fp,&s->buffer,&s->size,"scanLine"),length);
+    }
+
+void
+freeSCANNER(SCANNER *s)
+    {
+    free(s->buffer);
+    free(s);
+    }
+
+/********** private functions **********************/
+
+static void
+skipWhiteSpace(FILE *fp)
+    {
+    int ch;
+
+    /* read chars until a non-whitespace character is encountered */
+
+    while ((ch = fgetc(fp)) != EOF && isspace(ch))
+        continue;
+
+    /* a non-space character got us out of the loop, so push it back */
+
+    if (ch != EOF) ungetc(ch,fp);
+    }
+
+static char
+convertEscapedChar(int ch)
+    {
+    switch (ch)
+        {
+        case 'n':  return '\n';
+        case 't':  return '\t';
+        case '"':  return '\"';
+        case '\\': return '\\';
+        }
+    return ch;
+    }
+
+
+/* the collectors read into *buffer, doubling it (and *size) as needed,
+ * and return the length collected, or -1 if end of file came first */
+
+static int
+collectString(FILE *fp,char **buffer,int *size,char *where)
+    {
+    int ch,index;
+
+    /* advance to the double quote */
+
+    skipWhiteSpace(fp);
+
+    if (feof(fp)) return -1;
+
+    ch = fgetc(fp);
+
+    if (ch == EOF) return -1;
 
     if (ch != '\"')
         {
@@ -183,11 +337,7 @@ readString(FILE *fp)
             fprintf(stderr,"no closing double quote\n");
             exit(6);
             }
-        if (index > size - 2)
-            {
-            ++size;
-            buffer = reallocateMsg(buffer,size,"readString");
-            }
+        if (index > *size - 2) grow(buffer,size,where);
 
         if (ch == '\\')
             {
@@ -198,43 +348,35 @@ readString(FILE *fp)
                 fprintf(stderr,"escaped character missing\n");
                 exit(6);
                 }
-            buffer[index] = convertEscapedChar(ch);
+            (*buffer)[index] = convertEscapedChar(ch);
             }
         else
-            buffer[index] = ch;
+            (*buffer)[index] = ch;
         ++index;
         ch = fgetc(fp);
         }
 
-    buffer[index] = '\0';
+    (*buffer)[index] = '\0';
 
-    return buffer;
+    return index;
     }
 
-char *
-readToken(FILE *fp)
+static int
+collectToken(FILE *fp,char **buffer,int *size,char *where)
     {
     int ch,index;
-    char *buffer;
-    int size = 80;
 
     skipWhiteSpace(fp);
 
     ch = fgetc(fp);
-    if (ch == EOF) return 0;
-
-    buffer = allocateMsg(size,"readToken");
+    if (ch == EOF) return -1;
 
     index = 0;
     while (!isspace(ch))
         {
         if (ch == EOF) break;
-        if (index > size - 2)
-            {
-            ++size;
-            buffer = reallocateMsg(buffer,size,"readToken");
-            }
-        buffer[index] = ch;
+        if (index > *size - 2) grow(buffer,size,where);
+        (*buffer)[index] = ch;
         ++index;
         ch = fgetc(fp);
         }
@@ -246,33 +388,25 @@ readToken(FILE *fp)
     if (index > 0)              //there is something in the buffer
         clearerr(fp);           //so force the read to be good
 
-    buffer[index] = '\0';
+    (*buffer)[index] = '\0';
 
-    return buffer;
+    return index;
     }
 
-char *
-readLine(FILE *fp)
+static int
+collectLine(FILE *fp,char **buffer,int *size,char *where)
     {
     int ch,index;
-    char *buffer;
-    int size = 512;
 
     ch = fgetc(fp);
-    if (ch == EOF) return 0;
-
-    buffer = allocateMsg(size,"readLine");
+    if (ch == EOF) return -1;
 
     index = 0;
     while (ch != '\n')
         {
         if (ch == EOF) break;
-        if (index > size - 2)
-            {
-            ++size;
-            buffer = reallocateMsg(buffer,size,"readLine");
-            }
-        buffer[index] = ch;
+        if (index > *size - 2) grow(buffer,size,where);
+        (*buffer)[index] = ch;
         ++index;
         ch = fgetc(fp);
         }
@@ -281,54 +415,28 @@ readLine(FILE *fp)
     if (index > 0)              //there is something in the buffer
         clearerr(fp);           //so force the read to be good
 
-    buffer[index] = '\0';
+    (*buffer)[index] = '\0';
 
-    return buffer;
+    return index;
     }
 
-int
-stringPending(FILE *fp)
-    {
-    int ch,result = 0;
-    skipWhiteSpace(fp);
-    ch = fgetc(fp);
-    if (ch == EOF) return 0;
-    if (ch == '\"') result = 1;
-    ungetc(ch,fp);
-    return result;
-    }
-
-/********** private functions **********************/
+/* doubling keeps the total copying linear in the length collected */
 
 static void
-skipWhiteSpace(FILE *fp)
+grow(char **buffer,int *size,char *where)
     {
-    int ch;
-
-    /* read chars until a non-whitespace character is encountered */
-
-    while ((ch = fgetc(fp)) != EOF && isspace(ch))
-        continue;
-
-    /* a non-space character got us out of the loop, so push it back */
-
-    if (ch != EOF) ungetc(ch,fp);
+    *size *= 2;
+    *buffer = reallocateMsg(*buffer,*size,where);
     }
 
-static char
-convertEscapedChar(int ch)
+static char *
+view(SCANNER *s,int length,int *lengthp)
     {
-    switch (ch)
-        {
-        case 'n':  return '\n';
-        case 't':  return '\t';
-        case '"':  return '\"';
-        case '\\': return '\\';
-        }
-    return ch;
+    if (length < 0) return 0;
+    if (lengthp != 0) *lengthp = length;
+    return s->buffer;
     }
 
-
 void *
 allocateMsg(size_t size,char *where)
     {
@@ -1,6 +1,6 @@
 #ifndef SCANNER_H
 #define SCANNER_H
-/* VERSION 1.3
+/* VERSION 1.4
  *
  * scanner.h - public interface to scanner.c, the scanner module
  *
@@ -14,4 +14,12 @@ extern char *readString(FILE *);
 extern char *readToken(FILE *);
 extern char *readLine(FILE *);
 extern int stringPending(FILE *);
+
+typedef struct scanner SCANNER;
+
+extern SCANNER *newSCANNER(FILE *);
+extern char *scanToken(SCANNER *,int *);
+extern char *scanString(SCANNER *,int *);
+extern char *scanLine(SCANNER *,int *);
+extern void freeSCANNER(SCANNER *);
 #endif
@@ -0,0 +1,531 @@
+/*
+ *  File:   skiplist.c
+ *  Author: Brett Heithold
+ *  Description: This is the implementation file for the skiplist module.
+ *  Links carry a mark in their low bit; a node whose links are marked is
+ *  deleted and is unlinked by whichever thread next walks past it. A
+ *  node's count only changes by compare-and-swap, and once it reaches zero
+ *  the node is dead for good: an insert that meets it helps finish the
+ *  deletion and then links a fresh node instead of reviving it.
+ *
+ *  Both the inserting and the deleting thread may be the last to touch a
+ *  node's links, so each drops one of two references once it has run a
+ *  clean-up search, and the node is retired to the epoch reclaimer when
+ *  both have.
+ */
+
+#include "skiplist.h"
+#include "epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#define MAX_LEVEL 24
+
+#define MARKED(p)   ((p) & 1)
+#define NODE(p)     ((SNODE *) ((p) & ~(uintptr_t) 1))
+
+
+/*
+ *  Type:   SNODE
+ *  Description: This is a skip list node with a tower of height links.
+ */
+typedef struct snode {
+    void *value;
+    atomic_int count;
+    atomic_int owners;
+    int height;
+    _Atomic(uintptr_t) next[];
+} SNODE;
+
+
+/*
+ *  Type:   SEED
+ *  Description: This is the per-handle random state for tower heights,
+ *  padded to a cache line.
+ */
+typedef struct seed {
+    _Alignas(64) uint64_t state;
+} SEED;
+
+
+// SKIPLIST private method prototypes
+static SNODE *newSNODE(void *v, int height);
+static int randomHeight(SKIPLIST *s, int slot);
+static SNODE *search(SKIPLIST *s, void *v, SNODE **preds, SNODE **succs);
+static SNODE *lookup(SKIPLIST *s, void *v);
+static SNODE *firstLive(SNODE *n);
+static void mark(SNODE *n);
+static void release(SKIPLIST *s, int slot, SNODE *n);
+
+
+/*
+ *  Type:   SKIPLIST
+ *  Description: This is the struct definition for the SKIPLIST class.
+ */
+struct SKIPLIST {
+    SNODE *head;
+    EPOCH *epoch;
+    atomic_int size;
+    atomic_int nodes;
+    void (*display)(void *, FILE *);
+    int (*compare)(void *, void *);
+    void (*free)(void *);
+    SEED seed[EPOCH_SLOTS];
+};
+
+
+/*
+ *  Constructor: newSKIPLIST
+ *  Usage:  SKIPLIST *s = newSKIPLIST(displayINTEGER, compareINTEGER, freeINTEGER);
+ *  Description: This is the constructor used to instantiate a new SKIPLIST
+ *  object.
+ */
+SKIPLIST *newSKIPLIST(
+        void (*d)(void *, FILE *),
+        int (*c)(void *, void *),
+        void (*f)(void *)) {
+    SKIPLIST *s = aligned_alloc(64, sizeof(SKIPLIST));
+    assert(s != 0);
+    s->head = newSNODE(NULL, MAX_LEVEL);
+    s->epoch = newEPOCH();
+    atomic_init(&s->size, 0);
+    atomic_init(&s->nodes, 0);
+    s->display = d;
+    s->compare = c;
+    s->free = f;
+    for (int i = 0; i < EPOCH_SLOTS; i++) {
+        s->seed[i].state = 0x9E3779B97F4A7C15ULL * (i + 1);
+    }
+    return s;
+}
+
+
+/*
+ *  Method: registerSKIPLIST
+ *  Usage:  int slot = registerSKIPLIST(s);
+ *  Description: This method returns a handle for the calling thread.
+ */
+int registerSKIPLIST(SKIPLIST *s) {
+    assert(s != 0);
+    return registerEPOCH(s->epoch);
+}
+
+
+/*
+ *  Method: insertSKIPLIST
+ *  Usage:  insertSKIPLIST(s, slot, value);
+ *  Description: This method inserts a value, or increments its count if it
+ *  is already present. It runs in expected logarithmic time.
+ */
+void insertSKIPLIST(SKIPLIST *s, int slot, void *v) {
+    assert(s != 0);
+    SNODE *preds[MAX_LEVEL];
+    SNODE *succs[MAX_LEVEL];
+    enterEPOCH(s->epoch, slot);
+    SNODE *n;
+    for (;;) {
+        SNODE *found = search(s, v, preds, succs);
+        if (found != NULL) {
+            // List already contains the value
+            int c = atomic_load(&found->count);
+            if (c == 0) {
+                mark(found);
+                continue;
+            }
+            if (atomic_compare_exchange_weak(&found->count, &c, c + 1)) {
+                atomic_fetch_add(&s->size, 1);
+                exitEPOCH(s->epoch, slot);
+                return;
+            }
+            continue;
+        }
+        n = newSNODE(v, randomHeight(s, slot));
+        for (int i = 0; i < n->height; i++) {
+            atomic_init(&n->next[i], (uintptr_t) succs[i]);
+        }
+        uintptr_t expected = (uintptr_t) succs[0];
+        if (atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t) n)) {
+            break;
+        }
+        free(n);
+    }
+    atomic_fetch_add(&s->nodes, 1);
+    atomic_fetch_add(&s->size, 1);
+    // Build the rest of the tower, giving up if a delete has started
+    for (int i = 1; i < n->height; i++) {
+        for (;;) {
+            uintptr_t next = atomic_load(&n->next[i]);
+            if (MARKED(next)) goto built;
+            if (NODE(next) != succs[i] &&
+                    !atomic_compare_exchange_strong(&n->next[i], &next, (uintptr_t) succs[i])) {
+                continue;
+            }
+            uintptr_t expected = (uintptr_t) succs[i];
+            if (atomic_compare_exchange_strong(&preds[i]->next[i], &expected, (uintptr_t) n)) {
+                break;
+            }
+            if (search(s, v, preds, succs) != n) goto built;
+        }
+    }
+built:
+    if (MARKED(atomic_load(&n->next[0]))) search(s, v, preds, succs);
+    release(s, slot, n);
+    exitEPOCH(s->epoch, slot);
+}
+
+
+/*
+ *  Method: findSKIPLISTcount
+ *  Usage:  int count = findSKIPLISTcount(s, slot, value);
+ *  Description: This method returns the count of a value, or zero.
+ */
+int findSKIPLISTcount(SKIPLIST *s, int slot, void *v) {
+    assert(s != 0);
+    enterEPOCH(s->epoch, slot);
+    SNODE *n = lookup(s, v);
+    int count = n == NULL ? 0 : atomic_load(&n->count);
+    exitEPOCH(s->epoch, slot);
+    return count;
+}
+
+
+/*
+ *  Method: findSKIPLIST
+ *  Usage:  void *found = findSKIPLIST(s, slot, value);
+ *  Description: This method returns the stored value equal to the given
+ *  value, or NULL.
+ */
+void *findSKIPLIST(SKIPLIST *s, int slot, void *v) {
+    assert(s != 0);
+    enterEPOCH(s->epoch, slot);
+    SNODE *n = lookup(s, v);
+    void *found = n == NULL ? NULL : n->value;
+    exitEPOCH(s->epoch, slot);
+    return found;
+}
+
+
+/*
+ *  Method: deleteSKIPLIST
+ *  Usage:  void *removed = deleteSKIPLIST(s, slot, value);
+ *  Description: This method removes one occurrence of a value, returning
+ *  what deleteAVL would. The stored value may still be seen by concurrent
+ *  readers, so it must not be freed while other threads are running.
+ */
+void *deleteSKIPLIST(SKIPLIST *s, int slot, void *v) {
+    assert(s != 0);
+    SNODE *preds[MAX_LEVEL];
+    SNODE *succs[MAX_LEVEL];
+    enterEPOCH(s->epoch, slot);
+    SNODE *n = search(s, v, preds, succs);
+    int c = n == NULL ? 0 : atomic_load(&n->count);
+    while (c > 0 && !atomic_compare_exchange_weak(&n->count, &c, c - 1)) continue;
+    if (c == 0) {
+        // Value not found
+        exitEPOCH(s->epoch, slot);
+        return NULL;
+    }
+    atomic_fetch_sub(&s->size, 1);
+    if (c > 1) {
+        // Value has duplicates
+        exitEPOCH(s->epoch, slot);
+        return v;
+    }
+    atomic_fetch_sub(&s->nodes, 1);
+    void *rv = n->value;
+    mark(n);
+    search(s, v, preds, succs);
+    release(s, slot, n);
+    exitEPOCH(s->epoch, slot);
+    return rv;
+}
+
+
+/*
+ *  Method: sizeSKIPLIST
+ *  Usage:  int size = sizeSKIPLIST(s);
+ *  Description: This method returns the number of distinct values.
+ */
+int sizeSKIPLIST(SKIPLIST *s) {
+    assert(s != 0);
+    return atomic_load(&s->nodes);
+}
+
+
+/*
+ *  Method: duplicatesSKIPLIST
+ *  Usage:  int d = duplicatesSKIPLIST(s);
+ *  Description: This method returns the number of duplicate insertions.
+ */
+int duplicatesSKIPLIST(SKIPLIST *s) {
+    assert(s != 0);
+    return atomic_load(&s->size) - atomic_load(&s->nodes);
+}
+
+
+/*
+ *  Method: displaySKIPLIST
+ *  Usage:  displaySKIPLIST(s, stdout);
+ *  Description: This method displays the values in order, with counts
+ *  above one shown after a value. It must not run concurrently with
+ *  writers.
+ *  Example Output:
+ *                  [2 4[2] 5]
+ */
+void displaySKIPLIST(SKIPLIST *s, FILE *fp) {
+    assert(s != 0);
+    fprintf(fp, "[");
+    SNODE *n = firstLive(NODE(atomic_load(&s->head->next[0])));
+    while (n != NULL) {
+        s->display(n->value, fp);
+        int count = atomic_load(&n->count);
+        if (count > 1) fprintf(fp, "[%d]", count);
+        n = firstLive(NODE(atomic_load(&n->next[0])));
+        if (n != NULL) fprintf(fp, " ");
+    }
+    fprintf(fp, "]");
+}
+
+
+/*
+ *  Method: freeSKIPLIST
+ *  Usage:  freeSKIPLIST(s);
+ *  Description: This method frees every node still linked (and its value,
+ *  if there is a freeing function), every retired node, and the list
+ *  itself. No thread may be using the list.
+ */
+void freeSKIPLIST(SKIPLIST *s) {
+    assert(s != 0);
+    SNODE *n = s->head;
+    while (n != NULL) {
+        SNODE *next = NODE(atomic_load(&n->next[0]));
+        if (n != s->head && atomic_load(&n->count) > 0 && s->free != NULL) {
+            s->free(n->value);
+        }
+        free(n);
+        n = next;
+    }
+    freeEPOCH(s->epoch);
+    free(s);
+}
+
+
+/*
+ *  Type:   SKIPLISTCURSOR
+ *  Description: This is an in-order cursor. It holds its handle's epoch
+ *  open from creation until it is freed, so the handle must not be used
+ *  for anything else in between. Values inserted or deleted meanwhile may
+ *  or may not be seen.
+ */
+struct SKIPLISTCURSOR {
+    SKIPLIST *list;
+    int slot;
+    SNODE *node;
+};
+
+
+SKIPLISTCURSOR *newSKIPLISTCURSOR(SKIPLIST *s, int slot) {
+    assert(s != 0);
+    SKIPLISTCURSOR *c = malloc(sizeof(SKIPLISTCURSOR));
+    assert(c != 0);
+    c->list = s;
+    c->slot = slot;
+    enterEPOCH(s->epoch, slot);
+    firstSKIPLISTCURSOR(c);
+    return c;
+}
+
+void firstSKIPLISTCURSOR(SKIPLISTCURSOR *c) {
+    assert(c != 0);
+    c->node = firstLive(NODE(atomic_load(&c->list->head->next[0])));
+}
+
+void seekSKIPLISTCURSOR(SKIPLISTCURSOR *c, void *v) {
+    // Moves to the smallest value that is not less than v
+    assert(c != 0);
+    SKIPLIST *s = c->list;
+    SNODE *pred = s->head;
+    for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+        SNODE *curr = NODE(atomic_load(&pred->next[i]));
+        while (curr != NULL && s->compare(curr->value, v) < 0) {
+            pred = curr;
+            curr = NODE(atomic_load(&pred->next[i]));
+        }
+    }
+    c->node = firstLive(NODE(atomic_load(&pred->next[0])));
+}
+
+int moreSKIPLISTCURSOR(SKIPLISTCURSOR *c) {
+    assert(c != 0);
+    return c->node != NULL;
+}
+
+void nextSKIPLISTCURSOR(SKIPLISTCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    c->node = firstLive(NODE(atomic_load(&c->node->next[0])));
+}
+
+void *currentSKIPLISTCURSOR(SKIPLISTCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    return c->node->value;
+}
+
+int currentSKIPLISTCURSORcount(SKIPLISTCURSOR *c) {
+    assert(c != 0 && c->node != NULL);
+    return atomic_load(&c->node->count);
+}
+
+void freeSKIPLISTCURSOR(SKIPLISTCURSOR *c) {
+    exitEPOCH(c->list->epoch, c->slot);
+    free(c);
+}
+
+
+/****************************** Private Methods ******************************/
+
+
+/*
+ *  Constructor (private): newSNODE
+ *  Usage:  SNODE *n = newSNODE(value, height);
+ *  Description: This private constructor returns an unlinked node holding
+ *  one occurrence of v.
+ */
+SNODE *newSNODE(void *v, int height) {
+    SNODE *n = malloc(sizeof(SNODE) + sizeof(_Atomic(uintptr_t)) * height);
+    assert(n != 0);
+    n->value = v;
+    atomic_init(&n->count, 1);
+    atomic_init(&n->owners, 2);
+    n->height = height;
+    for (int i = 0; i < height; i++) atomic_init(&n->next[i], 0);
+    return n;
+}
+
+
+/*
+ *  Method (private):   randomHeight
+ *  Usage:  int height = randomHeight(s, slot);
+ *  Description: This private method returns a tower height with a one in
+ *  two chance of each extra level.
+ */
+int randomHeight(SKIPLIST *s, int slot) {
+    uint64_t x = s->seed[slot].state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    s->seed[slot].state = x;
+    int height = 1;
+    while (height < MAX_LEVEL && (x & 1)) {
+        height++;
+        x >>= 1;
+    }
+    return height;
+}
+
+
+/*
+ *  Method (private):   search
+ *  Usage:  SNODE *n = search(s, value, preds, succs);
+ *  Description: This private method finds, at every level, the last node
+ *  before v and the first unmarked node not before it, unlinking marked
+ *  nodes on the way. It returns the bottom level successor if it holds v.
+ */
+SNODE *search(SKIPLIST *s, void *v, SNODE **preds, SNODE **succs) {
+retry:
+    ;
+    SNODE *pred = s->head;
+    for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+        SNODE *curr = NODE(atomic_load(&pred->next[i]));
+        while (curr != NULL) {
+            uintptr_t succ = atomic_load(&curr->next[i]);
+            while (MARKED(succ)) {
+                uintptr_t expected = (uintptr_t) curr;
+                if (!atomic_compare_exchange_strong(&pred->next[i], &expected, (uintptr_t) NODE(succ))) {
+                    goto retry;
+                }
+                curr = NODE(succ);
+                if (curr == NULL) break;
+                succ = atomic_load(&curr->next[i]);
+            }
+            if (curr == NULL || s->compare(curr->value, v) >= 0) break;
+            pred = curr;
+            curr = NODE(succ);
+        }
+        preds[i] = pred;
+        succs[i] = curr;
+    }
+    if (succs[0] != NULL && s->compare(succs[0]->value, v) == 0) return succs[0];
+    return NULL;
+}
+
+
+/*
+ *  Method (private):   lookup
+ *  Usage:  SNODE *n = lookup(s, value);
+ *  Description: This private method is a read-only search that steps over
+ *  marked nodes instead of unlinking them. It returns the live node
+ *  holding v, or NULL.
+ */
+SNODE *lookup(SKIPLIST *s, void *v) {
+    SNODE *pred = s->head;
+    SNODE *curr = NULL;
+    for (int i = MAX_LEVEL - 1; i >= 0; i--) {
+        curr = NODE(atomic_load(&pred->next[i]));
+        while (curr != NULL) {
+            uintptr_t succ = atomic_load(&curr->next[i]);
+            while (MARKED(succ)) {
+                curr = NODE(succ);
+                if (curr == NULL) break;
+                succ = atomic_load(&curr->next[i]);
+            }
+            if (curr == NULL || s->compare(curr->value, v) >= 0) break;
+            pred = curr;
+            curr = NODE(succ);
+        }
+    }
+    if (curr == NULL || s->compare(curr->value, v) != 0) return NULL;
+    return atomic_load(&curr->count) > 0 ? curr : NULL;
+}
+
+
+/*
+ *  Method (private):   firstLive
+ *  Usage:  n = firstLive(n);
+ *  Description: This private method returns n or the first node after it
+ *  on the bottom level that has not been deleted.
+ */
+SNODE *firstLive(SNODE *n) {
+    while (n != NULL && atomic_load(&n->count) == 0) {
+        n = NODE(atomic_load(&n->next[0]));
+    }
+    return n;
+}
+
+
+/*
+ *  Method (private):   mark
+ *  Usage:  mark(n);
+ *  Description: This private method marks every link of a dead node, top
+ *  down, so that no new node can be linked after it. Any thread may help.
+ */
+void mark(SNODE *n) {
+    for (int i = n->height - 1; i >= 0; i--) {
+        atomic_fetch_or(&n->next[i], (uintptr_t) 1);
+    }
+}
+
+
+/*
+ *  Method (private):   release
+ *  Usage:  release(s, slot, n);
+ *  Description: This private method drops one of the two references to a
+ *  node and retires it when the last one goes.
+ */
+void release(SKIPLIST *s, int slot, SNODE *n) {
+    if (atomic_fetch_sub(&n->owners, 1) == 1) {
+        retireEPOCH(s->epoch, slot, n, free);
+    }
+}
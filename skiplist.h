@@ -0,0 +1,42 @@
+/*
+ *  File:   skiplist.h
+ *  Author: Brett Heithold
+ *  Description: This is the public interface for the skiplist module, a
+ *  lock-free ordered set with duplicate counts. Any number of threads may
+ *  insert, delete and search at once. Each thread needs its own handle
+ *  from registerSKIPLIST, passed to every operation.
+ */
+
+#ifndef __SKIPLIST_INCLUDED__
+#define __SKIPLIST_INCLUDED__
+
+#include <stdio.h>
+
+typedef struct SKIPLIST SKIPLIST;
+
+extern SKIPLIST *newSKIPLIST(
+        void (*)(void *, FILE *),
+        int (*)(void *, void *),
+        void (*)(void *));
+extern int registerSKIPLIST(SKIPLIST *);
+extern void insertSKIPLIST(SKIPLIST *, int, void *);
+extern int findSKIPLISTcount(SKIPLIST *, int, void *);
+extern void *findSKIPLIST(SKIPLIST *, int, void *);
+extern void *deleteSKIPLIST(SKIPLIST *, int, void *);
+extern int sizeSKIPLIST(SKIPLIST *);
+extern int duplicatesSKIPLIST(SKIPLIST *);
+extern void displaySKIPLIST(SKIPLIST *, FILE *);
+extern void freeSKIPLIST(SKIPLIST *);
+
+typedef struct SKIPLISTCURSOR SKIPLISTCURSOR;
+
+extern SKIPLISTCURSOR *newSKIPLISTCURSOR(SKIPLIST *, int);
+extern void firstSKIPLISTCURSOR(SKIPLISTCURSOR *);
+extern void seekSKIPLISTCURSOR(SKIPLISTCURSOR *, void *);
+extern int moreSKIPLISTCURSOR(SKIPLISTCURSOR *);
+extern void nextSKIPLISTCURSOR(SKIPLISTCURSOR *);
+extern void *currentSKIPLISTCURSOR(SKIPLISTCURSOR *);
+extern int currentSKIPLISTCURSORcount(SKIPLISTCURSOR *);
+extern void freeSKIPLISTCURSOR(SKIPLISTCURSOR *);
+
+#endif // !__SKIPLIST_INCLUDED__